@@ -0,0 +1,314 @@
+#include "AABBTree.h"
+#include <algorithm>
+
+AABBTree::AABB::AABB(const sf::FloatRect& rect)
+{
+    min = sf::Vector2f(std::min(rect.left, rect.left + rect.width), std::min(rect.top, rect.top + rect.height));
+    max = sf::Vector2f(std::max(rect.left, rect.left + rect.width), std::max(rect.top, rect.top + rect.height));
+}
+
+AABBTree::AABB AABBTree::AABB::combine(const AABB& a, const AABB& b)
+{
+    AABB result;
+    result.min = sf::Vector2f(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y));
+    result.max = sf::Vector2f(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y));
+    return result;
+}
+
+AABBTree::AABBTree(float m)
+{
+    margin = m;
+    root = -1;
+    freeList = -1;
+    proxyCount = 0;
+}
+
+void AABBTree::clear()
+{
+    nodes.clear();
+    root = -1;
+    freeList = -1;
+    proxyCount = 0;
+}
+
+int AABBTree::allocateNode()
+{
+    // Grow the pool and chain the new nodes onto the free list
+    if (freeList == -1) {
+        int oldCapacity = (int)nodes.size();
+        int newCapacity = std::max(16, oldCapacity * 2);
+        nodes.resize(newCapacity);
+        for (int i = oldCapacity; i < newCapacity; ++i) {
+            nodes[i].parent = (i + 1 < newCapacity) ? i + 1 : -1;
+            nodes[i].height = -1;
+        }
+        freeList = oldCapacity;
+    }
+
+    int index = freeList;
+    Node& node = nodes[index];
+    freeList = node.parent;
+    node.parent = -1;
+    node.child1 = -1;
+    node.child2 = -1;
+    node.height = 0;
+    node.userData = nullptr;
+    return index;
+}
+
+void AABBTree::freeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int AABBTree::createProxy(const sf::FloatRect& box, void* userData)
+{
+    int proxy = allocateNode();
+
+    AABB aabb(box);
+    nodes[proxy].box.min = aabb.min - sf::Vector2f(margin, margin);
+    nodes[proxy].box.max = aabb.max + sf::Vector2f(margin, margin);
+    nodes[proxy].userData = userData;
+
+    insertLeaf(proxy);
+    ++proxyCount;
+    return proxy;
+}
+
+void AABBTree::destroyProxy(int proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --proxyCount;
+}
+
+bool AABBTree::moveProxy(int proxy, const sf::FloatRect& box, sf::Vector2f displacement)
+{
+    AABB aabb(box);
+    if (nodes[proxy].box.contains(aabb)) {
+        return false;
+    }
+
+    // Fatten the box, and stretch it the way the object is moving so it stays inside for longer
+    AABB fat;
+    fat.min = aabb.min - sf::Vector2f(margin, margin);
+    fat.max = aabb.max + sf::Vector2f(margin, margin);
+    if (displacement.x < 0.f) fat.min.x += displacement.x;
+    else fat.max.x += displacement.x;
+    if (displacement.y < 0.f) fat.min.y += displacement.y;
+    else fat.max.y += displacement.y;
+
+    removeLeaf(proxy);
+    nodes[proxy].box = fat;
+    insertLeaf(proxy);
+    return true;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+    if (root == -1) {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    // Walk down the tree choosing the cheapest sibling, cost is the increase in perimeter (surface area heuristic)
+    AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = nodes[index].box.getPerimeter();
+        float combinedArea = AABB::combine(nodes[index].box, leafBox).getPerimeter();
+
+        // Cost of making a new parent for this node and the new leaf
+        float cost = 2.f * combinedArea;
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.f * (combinedArea - area);
+
+        float cost1 = AABB::combine(leafBox, nodes[child1].box).getPerimeter() + inheritanceCost;
+        if (!nodes[child1].isLeaf()) cost1 -= nodes[child1].box.getPerimeter();
+        float cost2 = AABB::combine(leafBox, nodes[child2].box).getPerimeter() + inheritanceCost;
+        if (!nodes[child2].isLeaf()) cost2 -= nodes[child2].box.getPerimeter();
+
+        if (cost < cost1 && cost < cost2) break;
+        index = (cost1 < cost2) ? child1 : child2;
+    }
+    int sibling = index;
+
+    // New parent for the sibling and the leaf
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = AABB::combine(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != -1) {
+        if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else nodes[oldParent].child2 = newParent;
+    }
+    else {
+        root = newParent;
+    }
+
+    // Walk back up fixing the heights and boxes, rebalancing on the way
+    index = nodes[leaf].parent;
+    while (index != -1) {
+        index = balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].box = AABB::combine(nodes[child1].box, nodes[child2].box);
+
+        index = nodes[index].parent;
+    }
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != -1) {
+        // Replace the parent with the sibling and free the parent
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        int index = grandParent;
+        while (index != -1) {
+            index = balance(index);
+
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+            nodes[index].box = AABB::combine(nodes[child1].box, nodes[child2].box);
+            nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+
+            index = nodes[index].parent;
+        }
+    }
+    else {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        freeNode(parent);
+    }
+}
+
+// Performs a left or right rotation if node A is imbalanced, returns the new root of the subtree
+int AABBTree::balance(int iA)
+{
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+
+    int balanceFactor = C.height - B.height;
+
+    // Rotate C up
+    if (balanceFactor > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        // Swap A and C
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        // A's old parent should point to C
+        if (C.parent != -1) {
+            if (nodes[C.parent].child1 == iA) nodes[C.parent].child1 = iC;
+            else nodes[C.parent].child2 = iC;
+        }
+        else {
+            root = iC;
+        }
+
+        // Rotate, the taller grandchild stays under C
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = AABB::combine(B.box, G.box);
+            C.box = AABB::combine(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = AABB::combine(B.box, F.box);
+            C.box = AABB::combine(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // Rotate B up
+    if (balanceFactor < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        // Swap A and B
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        // A's old parent should point to B
+        if (B.parent != -1) {
+            if (nodes[B.parent].child1 == iA) nodes[B.parent].child1 = iB;
+            else nodes[B.parent].child2 = iB;
+        }
+        else {
+            root = iB;
+        }
+
+        // Rotate, the taller grandchild stays under B
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = AABB::combine(C.box, E.box);
+            B.box = AABB::combine(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = AABB::combine(C.box, D.box);
+            B.box = AABB::combine(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
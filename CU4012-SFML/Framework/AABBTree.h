@@ -0,0 +1,207 @@
+// AABB Tree Class
+// Dynamic bounding volume hierarchy used as a broadphase and for spatial queries.
+// Each proxy is a leaf holding a fattened copy of an object's collision box, so objects that only move a little
+// stay inside their fat box and do not need to be reinserted. The tree is kept balanced with rotations as leaves are
+// inserted and removed, so adding and deleting lots of tiles in the editor does not leave it degenerate.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+#include <cmath>
+
+class AABBTree
+{
+public:
+	// Axis aligned box stored as min/max corners, cheaper to combine than sf::FloatRect
+	struct AABB
+	{
+		sf::Vector2f min;
+		sf::Vector2f max;
+
+		AABB() {}
+		AABB(const sf::FloatRect& rect);
+
+		bool overlaps(const AABB& other) const
+		{
+			return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+		}
+		bool contains(const AABB& other) const
+		{
+			return min.x <= other.min.x && min.y <= other.min.y && other.max.x <= max.x && other.max.y <= max.y;
+		}
+		float getPerimeter() const { return 2.f * ((max.x - min.x) + (max.y - min.y)); }
+		static AABB combine(const AABB& a, const AABB& b);
+	};
+
+	AABBTree(float margin = 8.f);
+
+	// Extra space added around each box so small movements do not need a reinsert
+	void setMargin(float m) { margin = m; }
+	float getMargin() const { return margin; }
+
+	// Creates a leaf for the box and returns its proxy id
+	int createProxy(const sf::FloatRect& box, void* userData);
+	void destroyProxy(int proxy);
+	// Moves a proxy, the displacement is the expected movement over the next step and extends the fat box in that direction.
+	// Returns true if the proxy left its fat box and was reinserted.
+	bool moveProxy(int proxy, const sf::FloatRect& box, sf::Vector2f displacement);
+	void clear();
+
+	void* getUserData(int proxy) const { return nodes[proxy].userData; }
+	const AABB& getFatAABB(int proxy) const { return nodes[proxy].box; }
+
+	// Height of the tree, a balanced tree of n leaves is about log2(n) high
+	int getHeight() const { return root == -1 ? 0 : nodes[root].height; }
+	int getProxyCount() const { return proxyCount; }
+
+	// Calls callback(proxy) for every proxy whose fat box overlaps the box. Return false from the callback to stop.
+	template <typename T>
+	void query(const sf::FloatRect& box, T&& callback) const;
+
+	// Calls callback(proxy) for every proxy whose fat box contains the point. Return false from the callback to stop.
+	template <typename T>
+	void queryPoint(sf::Vector2f point, T&& callback) const;
+
+	// Casts the segment p1 -> p2 through the tree, calling callback(proxy, maxFraction) for every proxy whose fat box it may hit.
+	// The callback returns the fraction along the segment of its hit to clip the ray, a negative value to ignore the proxy, or 0 to stop.
+	template <typename T>
+	void raycast(sf::Vector2f p1, sf::Vector2f p2, T&& callback) const;
+
+private:
+	struct Node
+	{
+		AABB box;
+		void* userData;
+		int parent;		// next free node while on the free list
+		int child1;
+		int child2;
+		int height;		// 0 for leaves, -1 for free nodes
+
+		bool isLeaf() const { return child1 == -1; }
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int index);
+
+	std::vector<Node> nodes;
+	int root;
+	int freeList;
+	int proxyCount;
+	float margin;
+
+	// Traversal stack for the queries. Lives on the call stack so callbacks can run their own queries,
+	// only allocates if the tree is deeper than a balanced tree of millions of leaves would be
+	class Stack
+	{
+		int fixed[128];
+		std::vector<int> overflow;
+		int count = 0;
+	public:
+		void push(int value)
+		{
+			if (count < 128) fixed[count] = value;
+			else overflow.push_back(value);
+			++count;
+		}
+		int pop()
+		{
+			--count;
+			if (count < 128) return fixed[count];
+			int value = overflow.back();
+			overflow.pop_back();
+			return value;
+		}
+		bool empty() const { return count == 0; }
+	};
+};
+
+template <typename T>
+void AABBTree::query(const sf::FloatRect& box, T&& callback) const
+{
+	if (root == -1) return;
+
+	AABB aabb(box);
+	Stack stack;
+	stack.push(root);
+	while (!stack.empty())
+	{
+		int index = stack.pop();
+
+		const Node& node = nodes[index];
+		if (!node.box.overlaps(aabb)) continue;
+
+		if (node.isLeaf())
+		{
+			if (!callback(index)) return;
+		}
+		else
+		{
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+template <typename T>
+void AABBTree::queryPoint(sf::Vector2f point, T&& callback) const
+{
+	query(sf::FloatRect(point.x, point.y, 0.f, 0.f), callback);
+}
+
+template <typename T>
+void AABBTree::raycast(sf::Vector2f p1, sf::Vector2f p2, T&& callback) const
+{
+	if (root == -1) return;
+
+	sf::Vector2f d = p2 - p1;
+	float length = std::sqrt(d.x * d.x + d.y * d.y);
+	if (length == 0.f) return;
+
+	// Perpendicular to the ray, used to reject boxes the infinite line misses
+	sf::Vector2f v(-d.y / length, d.x / length);
+	sf::Vector2f absV(std::abs(v.x), std::abs(v.y));
+
+	float maxFraction = 1.f;
+	AABB segment;
+	sf::Vector2f end = p1 + maxFraction * d;
+	segment.min = sf::Vector2f(std::min(p1.x, end.x), std::min(p1.y, end.y));
+	segment.max = sf::Vector2f(std::max(p1.x, end.x), std::max(p1.y, end.y));
+
+	Stack stack;
+	stack.push(root);
+	while (!stack.empty())
+	{
+		int index = stack.pop();
+
+		const Node& node = nodes[index];
+		if (!node.box.overlaps(segment)) continue;
+
+		// Separating axis test between the line and the box
+		sf::Vector2f centre = (node.box.min + node.box.max) * 0.5f;
+		sf::Vector2f extents = (node.box.max - node.box.min) * 0.5f;
+		sf::Vector2f offset = p1 - centre;
+		float separation = std::abs(v.x * offset.x + v.y * offset.y) - (absV.x * extents.x + absV.y * extents.y);
+		if (separation > 0.f) continue;
+
+		if (node.isLeaf())
+		{
+			float value = callback(index, maxFraction);
+			if (value == 0.f) return;
+			if (value > 0.f && value < maxFraction)
+			{
+				maxFraction = value;
+				end = p1 + maxFraction * d;
+				segment.min = sf::Vector2f(std::min(p1.x, end.x), std::min(p1.y, end.y));
+				segment.max = sf::Vector2f(std::max(p1.x, end.x), std::max(p1.y, end.y));
+			}
+		}
+		else
+		{
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
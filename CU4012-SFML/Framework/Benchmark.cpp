@@ -0,0 +1,579 @@
+#include "Benchmark.h"
+#include "SpatialHash.h"
+#include "SweepAndPrune.h"
+#include "AABBTree.h"
+#include "BoxBatch.h"
+#include "Collision.h"
+#include "World.h"
+#include "Narrowphase.h"
+#include "TileMap.h"
+#include <thread>
+#include <iostream>
+#include <algorithm>
+
+void Benchmark::run()
+{
+    int counts[] = { 1000, 10000, 100000 };
+    for (int count : counts) {
+        broadphase(count);
+    }
+    for (int count : counts) {
+        overlapKernel(count, count >= 100000 ? 100 : 1000);
+    }
+    for (int count : counts) {
+        narrowphase(count);
+    }
+    for (int count : counts) {
+        raycast(count);
+    }
+    for (int count : counts) {
+        picking(count);
+    }
+    for (int count : counts) {
+        colliders(count);
+    }
+    for (int count : counts) {
+        collisionGrid(count);
+    }
+}
+
+// Small deterministic random generator so every run measures the same scene
+static float nextRandom(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.f;
+}
+
+std::vector<sf::FloatRect> Benchmark::makeLevel(int bodyCount, unsigned int seed)
+{
+    // Roughly 20 bodies per screen width, 5 screens high, like a long platformer level
+    float levelWidth = bodyCount * 100.f;
+    float levelHeight = 5000.f;
+
+    std::vector<sf::FloatRect> boxes;
+    boxes.reserve(bodyCount);
+    for (int i = 0; i < bodyCount; ++i) {
+        float w = 20.f + nextRandom(seed) * 80.f;
+        float h = 20.f + nextRandom(seed) * 80.f;
+        boxes.push_back(sf::FloatRect(nextRandom(seed) * levelWidth, nextRandom(seed) * levelHeight, w, h));
+    }
+    return boxes;
+}
+
+void Benchmark::jitter(std::vector<sf::FloatRect>& boxes, unsigned int& seed)
+{
+    for (auto& box : boxes) {
+        box.left += (nextRandom(seed) - 0.5f) * 4.f;
+        box.top += (nextRandom(seed) - 0.5f) * 4.f;
+    }
+}
+
+void Benchmark::broadphase(int bodyCount, int steps)
+{
+    std::vector<sf::FloatRect> level = makeLevel(bodyCount, 1234u);
+    std::vector<sf::FloatRect> boxes;
+    unsigned int seed;
+    sf::Clock clock;
+
+    // Brute force is quadratic, keep the total work bounded on the big scenes
+    int bruteSteps = std::max(1, std::min(steps, steps * 1000 / bodyCount));
+    boxes = level;
+    seed = 42u;
+    size_t brutePairs = 0;
+    clock.restart();
+    for (int step = 0; step < bruteSteps; ++step) {
+        jitter(boxes, seed);
+        brutePairs = 0;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            for (size_t j = i + 1; j < boxes.size(); ++j) {
+                if (boxes[i].intersects(boxes[j])) ++brutePairs;
+            }
+        }
+    }
+    float bruteTime = clock.getElapsedTime().asSeconds() * 1000.f / bruteSteps;
+
+    boxes = level;
+    seed = 42u;
+    SpatialHash hash;
+    std::vector<std::pair<int, int>> pairs;
+    clock.restart();
+    for (int step = 0; step < steps; ++step) {
+        jitter(boxes, seed);
+        hash.clear();
+        for (int i = 0; i < (int)boxes.size(); ++i) {
+            hash.insert(i, boxes[i]);
+        }
+        hash.getPairs(pairs);
+    }
+    float hashTime = clock.getElapsedTime().asSeconds() * 1000.f / steps;
+    size_t hashPairs = pairs.size();
+
+    // Proxies are created up front, the first update sorts from scratch and is not timed
+    boxes = level;
+    seed = 42u;
+    SweepAndPrune sap;
+    for (auto& box : boxes) {
+        sap.createProxy(box);
+    }
+    sap.update();
+    size_t changes = 0;
+    clock.restart();
+    for (int step = 0; step < steps; ++step) {
+        jitter(boxes, seed);
+        for (int i = 0; i < (int)boxes.size(); ++i) {
+            sap.moveProxy(i, boxes[i]);
+        }
+        sap.update();
+        changes += sap.getAddedPairs().size() + sap.getRemovedPairs().size();
+    }
+    float sapTime = clock.getElapsedTime().asSeconds() * 1000.f / steps;
+
+    boxes = level;
+    seed = 42u;
+    AABBTree tree;
+    std::vector<int> proxies;
+    for (auto& box : boxes) {
+        proxies.push_back(tree.createProxy(box, nullptr));
+    }
+    size_t treePairs = 0;
+    clock.restart();
+    for (int step = 0; step < steps; ++step) {
+        std::vector<sf::FloatRect> previous = boxes;
+        jitter(boxes, seed);
+        treePairs = 0;
+        for (int i = 0; i < (int)boxes.size(); ++i) {
+            sf::Vector2f displacement(boxes[i].left - previous[i].left, boxes[i].top - previous[i].top);
+            tree.moveProxy(proxies[i], boxes[i], displacement);
+        }
+        for (auto& box : boxes) {
+            tree.query(box, [&treePairs](int) {
+                ++treePairs;
+                return true;
+            });
+        }
+    }
+    float treeTime = clock.getElapsedTime().asSeconds() * 1000.f / steps;
+
+    std::cout << "Broadphase, " << bodyCount << " bodies\n";
+    std::cout << "  Brute force:     " << bruteTime << " ms/step (" << brutePairs << " overlaps, " << bruteSteps << " steps)\n";
+    std::cout << "  Spatial hash:    " << hashTime << " ms/step (" << hashPairs << " candidate pairs)\n";
+    std::cout << "  Sweep and prune: " << sapTime << " ms/step (" << sap.getPairs().size() << " candidate pairs, "
+        << changes / steps << " added/removed per step)\n";
+    std::cout << "  AABB tree:       " << treeTime << " ms/step (" << (treePairs - boxes.size()) / 2 << " candidate pairs, height "
+        << tree.getHeight() << ")\n";
+}
+
+void Benchmark::overlapKernel(int boxCount, int queries)
+{
+    std::vector<sf::FloatRect> boxes = makeLevel(boxCount, 1234u);
+    std::vector<sf::FloatRect> queryBoxes(boxes.begin(), boxes.begin() + std::min(queries, boxCount));
+    sf::Clock clock;
+
+    size_t scalarHits = 0;
+    clock.restart();
+    for (auto& query : queryBoxes) {
+        for (auto& box : boxes) {
+            if (query.intersects(box)) ++scalarHits;
+        }
+    }
+    float scalarTime = clock.getElapsedTime().asSeconds() * 1000.f;
+
+    std::cout << "Overlap kernel, " << queryBoxes.size() << " queries against " << boxCount << " boxes\n";
+    std::cout << "  FloatRect::intersects: " << scalarTime << " ms (" << scalarHits << " hits)\n";
+
+    const char* names[] = { "Batch scalar:         ", "Batch SSE2:           ", "Batch AVX2:           " };
+    BoxBatch batch;
+    for (auto& box : boxes) {
+        batch.add(box);
+    }
+    std::vector<int> hits;
+    for (int l = 0; l <= (int)BoxBatch::getSupportedLevel(); ++l) {
+        batch.setLevel((SimdLevel)l);
+        size_t batchHits = 0;
+        clock.restart();
+        for (auto& query : queryBoxes) {
+            hits.clear();
+            batch.query(query, hits);
+            batchHits += hits.size();
+        }
+        float time = clock.getElapsedTime().asSeconds() * 1000.f;
+        std::cout << "  " << names[l] << time << " ms (" << batchHits << " hits, x" << (time > 0.f ? scalarTime / time : 0.f) << ")\n";
+    }
+}
+
+// Box that keeps its collision box on its shape, static ones included
+class BenchmarkBody : public GameObject
+{
+public:
+    BenchmarkBody(sf::FloatRect box, bool isStatic)
+    {
+        setPosition(box.left, box.top);
+        setSize(sf::Vector2f(box.width, box.height));
+        setStatic(isStatic);
+        setTrigger(false);
+        setTile(isStatic);
+        setMassless(false);
+        updateCollisionBox(0.f);
+    }
+    void update(float dt) override { updateCollisionBox(dt); }
+};
+
+void Benchmark::narrowphase(int bodyCount, int steps)
+{
+    // Columns of overlapping boxes falling onto a floor, so most candidate pairs are real collisions
+    unsigned int seed = 99u;
+    int columns = std::max(1, bodyCount / 50);
+    std::vector<sf::FloatRect> dynamicBoxes;
+    std::vector<sf::FloatRect> staticBoxes;
+    for (int i = 0; i < bodyCount; ++i) {
+        int column = i % columns;
+        int row = i / columns;
+        dynamicBoxes.push_back(sf::FloatRect(column * 60.f + nextRandom(seed) * 10.f, -row * 30.f, 40.f, 40.f));
+    }
+    for (int i = 0; i < columns * 2; ++i) {
+        staticBoxes.push_back(sf::FloatRect(i * 30.f, 50.f, 32.f, 32.f));
+    }
+
+    int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<sf::Vector2f> reference;
+    float baseTime = 0.f;
+
+    std::cout << "Narrowphase, " << bodyCount << " bodies\n";
+    for (int threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+        World world;
+        world.setGravity(sf::Vector2f(0.f, 980.f));
+        world.setThreadCount(threads);
+
+        std::vector<BenchmarkBody*> bodies;
+        for (auto& box : staticBoxes) {
+            bodies.push_back(new BenchmarkBody(box, true));
+        }
+        for (auto& box : dynamicBoxes) {
+            bodies.push_back(new BenchmarkBody(box, false));
+        }
+        for (auto& body : bodies) {
+            world.AddGameObject(*body);
+        }
+
+        // The first step builds the static index and the tree, it is not timed
+        world.UpdatePhysics(1.f / 60.f);
+        sf::Clock clock;
+        for (int step = 0; step < steps; ++step) {
+            world.UpdatePhysics(1.f / 60.f);
+        }
+        float time = clock.getElapsedTime().asSeconds() * 1000.f / steps;
+
+        std::vector<sf::Vector2f> positions;
+        for (auto& body : bodies) {
+            positions.push_back(body->getPosition());
+        }
+        if (threads == 1) {
+            reference = positions;
+            baseTime = time;
+        }
+
+        std::cout << "  " << threads << " thread" << (threads == 1 ? ": " : "s:") << "  " << time << " ms/step ("
+            << world.getPairCount() << " pairs, " << world.getContactCount() << " contacts, x"
+            << (time > 0.f ? baseTime / time : 0.f) << ")" << (positions == reference ? "" : " RESULTS DIFFER") << "\n";
+
+        // The world is not stepped again, so the bodies can be deleted without removing them one at a time
+        for (auto& body : bodies) {
+            delete body;
+        }
+
+        if (threads == maxThreads) break;
+    }
+}
+
+void Benchmark::raycast(int bodyCount, int rayCount)
+{
+    std::vector<sf::FloatRect> level = makeLevel(bodyCount, 1234u);
+    World world;
+    std::vector<BenchmarkBody*> bodies;
+    for (auto& box : level) {
+        bodies.push_back(new BenchmarkBody(box, true));
+        world.AddGameObject(*bodies.back());
+    }
+    world.UpdatePhysics(1.f / 60.f);
+
+    // Rays up to 400 long from random points in the level, like enemies looking for the player
+    unsigned int seed = 7u;
+    std::vector<Ray> rays;
+    for (int i = 0; i < rayCount; ++i) {
+        sf::Vector2f start(nextRandom(seed) * bodyCount * 100.f, nextRandom(seed) * 5000.f);
+        sf::Vector2f end = start + sf::Vector2f((nextRandom(seed) - 0.5f) * 800.f, (nextRandom(seed) - 0.5f) * 800.f);
+        rays.push_back({ start, end });
+    }
+
+    sf::Clock clock;
+    int scanHits = 0;
+    for (auto& ray : rays) {
+        float closest = 2.f;
+        for (auto& body : bodies) {
+            float fraction;
+            sf::Vector2f normal;
+            if (Collision::sweepBoundingBox(sf::FloatRect(ray.start.x, ray.start.y, 0.f, 0.f), ray.end - ray.start, body->getCollisionBox(), fraction, normal)) {
+                closest = std::min(closest, fraction);
+            }
+        }
+        if (closest <= 1.f) ++scanHits;
+    }
+    float scanTime = clock.getElapsedTime().asSeconds() * 1000.f;
+
+    std::vector<RaycastHit> hits;
+    clock.restart();
+    world.raycastBatch(rays, hits);
+    float batchTime = clock.getElapsedTime().asSeconds() * 1000.f;
+    int batchHits = 0;
+    for (auto& hit : hits) {
+        if (hit.object) ++batchHits;
+    }
+
+    std::cout << "Raycast, " << rayCount << " rays against " << bodyCount << " bodies\n";
+    std::cout << "  Every object:   " << scanTime << " ms (" << scanHits << " hits)\n";
+    std::cout << "  raycastBatch:   " << batchTime << " ms (" << batchHits << " hits, " << world.getThreadCount() << " threads)\n";
+
+    // The world is not used again, so the bodies can be deleted without removing them one at a time
+    for (auto& body : bodies) {
+        delete body;
+    }
+}
+
+void Benchmark::picking(int tileCount, int clicks)
+{
+    std::vector<sf::FloatRect> level = makeLevel(tileCount, 1234u);
+    World world;
+    std::vector<BenchmarkBody*> tiles;
+    for (auto& box : level) {
+        tiles.push_back(new BenchmarkBody(box, true));
+        world.AddGameObject(*tiles.back());
+    }
+    world.UpdatePhysics(1.f / 60.f);
+
+    // Click on random tiles so every click finds something
+    unsigned int seed = 11u;
+    std::vector<sf::Vector2i> points;
+    for (int i = 0; i < clicks; ++i) {
+        const sf::FloatRect& box = level[(int)(nextRandom(seed) * (tileCount - 1))];
+        points.push_back(sf::Vector2i((int)(box.left + box.width / 2.f), (int)(box.top + box.height / 2.f)));
+    }
+
+    sf::Clock clock;
+    int scanFound = 0;
+    for (auto& point : points) {
+        for (auto& tile : tiles) {
+            if (Collision::checkBoundingBox(tile->getCollisionBox(), point)) {
+                ++scanFound;
+                break;
+            }
+        }
+    }
+    float scanTime = clock.getElapsedTime().asSeconds() * 1000000.f / clicks;
+
+    clock.restart();
+    int queryFound = 0;
+    for (auto& point : points) {
+        bool found = false;
+        world.queryPoint(sf::Vector2f(point), [&found](GameObject*) {
+            found = true;
+            return false;
+        });
+        if (found) ++queryFound;
+    }
+    float queryTime = clock.getElapsedTime().asSeconds() * 1000000.f / clicks;
+
+    std::cout << "Picking, " << tileCount << " tiles\n";
+    std::cout << "  Every tile:  " << scanTime << " us/click (" << scanFound << " found)\n";
+    std::cout << "  queryPoint:  " << queryTime << " us/click (" << queryFound << " found)\n";
+
+    // The world is not used again, so the tiles can be deleted without removing them one at a time
+    for (auto& tile : tiles) {
+        delete tile;
+    }
+}
+
+void Benchmark::colliders(int pairCount)
+{
+    // One of each collider about 40 across
+    const sf::Vector2f hexagon[6] = {
+        sf::Vector2f(22.f, 0.f), sf::Vector2f(11.f, 19.f), sf::Vector2f(-11.f, 19.f),
+        sf::Vector2f(-22.f, 0.f), sf::Vector2f(-11.f, -19.f), sf::Vector2f(11.f, -19.f)
+    };
+    const Collider colliders[] = {
+        Collider::box(),
+        Collider::circle(20.f),
+        Collider::capsule(sf::Vector2f(-12.f, 0.f), sf::Vector2f(12.f, 0.f), 10.f),
+        Collider::orientedBox(sf::Vector2f(20.f, 12.f)),
+        Collider::polygon(hexagon, 6)
+    };
+    const char* names[] = { "Box", "Circle", "Capsule", "Oriented box", "Polygon" };
+    const int typeCount = (int)Collider::Type::Count;
+
+    // Centres up to 60 apart in each direction, so a good share of the pairs touch
+    unsigned int seed = 5u;
+    std::vector<ColliderTransform> transforms;
+    for (int i = 0; i < pairCount * 2; ++i) {
+        transforms.push_back(ColliderTransform(sf::Vector2f(nextRandom(seed) * 60.f, nextRandom(seed) * 60.f), nextRandom(seed) * 360.f));
+    }
+
+    std::cout << "Colliders, " << pairCount << " pairs of each type\n";
+    for (int a = 0; a < typeCount; ++a) {
+        for (int b = a; b < typeCount; ++b) {
+            std::vector<PlacedCollider> placed;
+            placed.reserve(pairCount * 2);
+            for (int i = 0; i < pairCount * 2; ++i) {
+                const Collider& collider = colliders[i % 2 == 0 ? a : b];
+                PlacedCollider p = { &collider, transforms[i], sf::FloatRect() };
+                if (collider.type == Collider::Type::Box) {
+                    // Boxes do not turn, their box is the collider
+                    p.transform = ColliderTransform(transforms[i].position, 0.f);
+                    p.box = sf::FloatRect(p.transform.position.x - 20.f, p.transform.position.y - 20.f, 40.f, 40.f);
+                }
+                else {
+                    p.box = collider.getBounds(p.transform);
+                }
+                placed.push_back(p);
+            }
+
+            int hits = 0;
+            float totalDepth = 0.f;
+            sf::Clock clock;
+            for (int i = 0; i < pairCount; ++i) {
+                sf::Vector2f normal;
+                float depth;
+                if (Narrowphase::collide(placed[i * 2], placed[i * 2 + 1], normal, depth)) {
+                    ++hits;
+                    totalDepth += depth;
+                }
+            }
+            float time = clock.getElapsedTime().asSeconds() * 1000000000.f / pairCount;
+
+            std::cout << "  " << names[a] << " - " << names[b] << ": " << time << " ns/pair (" << hits << " touching, average depth "
+                << (hits > 0 ? totalDepth / hits : 0.f) << ")\n";
+        }
+    }
+}
+
+// Counts its contacts with the ground below and any pushing it sideways, which a box sliding on flat ground should never get
+class SeamBody : public BenchmarkBody
+{
+public:
+    SeamBody(sf::FloatRect box) : BenchmarkBody(box, false) {}
+    void OnCollisionEnter(GameObject* /*other*/, const Contact& contact) override { count(contact); }
+    void OnCollisionStay(GameObject* /*other*/, const Contact& contact) override { count(contact); }
+    int groundContacts = 0;
+    int sideContacts = 0;
+
+private:
+    void count(const Contact& contact)
+    {
+        sf::Vector2f normal = contact.getNormal(this);
+        if (normal.x != 0.f) ++sideContacts;
+        else if (normal.y > 0.f) ++groundContacts;
+    }
+};
+
+void Benchmark::collisionGrid(int tileCount, int steps)
+{
+    // A long level, 32 cells high: 4 rows of ground and a 6 cell platform every 20 columns high above it, tile 0 is sky and tile 1 ground
+    const int mapHeight = 32;
+    const int groundRow = mapHeight - 4;
+    const float tileSize = 32.f;
+    int mapWidth = std::max(20, tileCount / 4);
+    std::vector<int> cells((size_t)mapWidth * mapHeight, 0);
+    for (int x = 0; x < mapWidth; ++x) {
+        for (int y = groundRow; y < mapHeight; ++y) {
+            cells[(size_t)y * mapWidth + x] = 1;
+        }
+        if (x % 20 < 6) {
+            cells[(size_t)12 * mapWidth + x] = 1;
+        }
+    }
+
+    std::vector<GameObject> tileSet(2);
+    for (auto& tile : tileSet) {
+        tile.setSize(sf::Vector2f(tileSize, tileSize));
+    }
+    TileMap map;
+    map.setTileSet(tileSet);
+    map.setTileMap(cells, sf::Vector2u(mapWidth, mapHeight));
+    map.buildLevel();
+
+    CollisionGrid grid;
+    grid.build(map, { 0 });
+
+    // The same boxes on both, stacked on the ground at the start of the level so the work done on them does not grow with the map
+    unsigned int seed = 5u;
+    std::vector<sf::FloatRect> dynamicBoxes;
+    for (int i = 0; i < 1000; ++i) {
+        float x = (i % 100) * 40.f + nextRandom(seed) * 8.f;
+        dynamicBoxes.push_back(sf::FloatRect(x, groundRow * tileSize - 24.f - (i / 100) * 26.f, 24.f, 24.f));
+    }
+
+    std::cout << "Collision grid, " << grid.getSolidCount() << " solid tiles (" << mapWidth << " x " << mapHeight << " map), "
+        << dynamicBoxes.size() << " bodies\n";
+    for (int useGrid = 1; useGrid >= 0; --useGrid) {
+        World world;
+        world.setGravity(sf::Vector2f(0.f, 980.f));
+
+        std::vector<BenchmarkBody*> bodies;
+        if (useGrid) {
+            world.setCollisionGrid(&grid);
+        }
+        else {
+            for (int i = 0; i < (int)cells.size(); ++i) {
+                if (cells[i] == 0) continue;
+                bodies.push_back(new BenchmarkBody(sf::FloatRect((i % mapWidth) * tileSize, (i / mapWidth) * tileSize, tileSize, tileSize), true));
+            }
+        }
+        for (auto& box : dynamicBoxes) {
+            bodies.push_back(new BenchmarkBody(box, false));
+        }
+        for (auto& body : bodies) {
+            world.AddGameObject(*body);
+        }
+
+        // The first step builds the static index and the tree, it is timed on its own
+        sf::Clock clock;
+        world.UpdatePhysics(1.f / 60.f);
+        float firstTime = clock.getElapsedTime().asSeconds() * 1000.f;
+        clock.restart();
+        for (int step = 0; step < steps; ++step) {
+            world.UpdatePhysics(1.f / 60.f);
+        }
+        float time = clock.getElapsedTime().asSeconds() * 1000.f / steps;
+
+        std::cout << (useGrid ? "  CollisionGrid:   " : "  Tile objects:    ") << time << " ms/step, first step " << firstTime << " ms ("
+            << world.getObjectCount() << " objects, " << world.getContactCount() << " contacts)\n";
+
+        // The world is not stepped again, so the bodies can be deleted without removing them one at a time
+        for (auto& body : bodies) {
+            delete body;
+        }
+    }
+
+    // A box pushed along the ground over 60 cells. Each cell is solid on its own, but the faces between them are inside the ground
+    World world;
+    world.setGravity(sf::Vector2f(0.f, 980.f));
+    world.setCollisionGrid(&grid);
+    SeamBody slider(sf::FloatRect(tileSize, groundRow * tileSize - tileSize, tileSize, tileSize));
+    world.AddGameObject(slider);
+    int gridSideContacts = 0;
+    CollisionGrid::GridContact contacts[CollisionGrid::maxContacts];
+    const float speed = 300.f;
+    int seamSteps = (int)(std::min(mapWidth - 2, 60) * tileSize * 60.f / speed);
+    for (int step = 0; step < seamSteps; ++step) {
+        slider.setVelocity(speed, slider.getVelocity().y);
+        world.UpdatePhysics(1.f / 60.f);
+        int count = grid.collide(slider.getCollisionBox(), slider.getCollisionLayer(), slider.getCollisionMask(), contacts);
+        for (int i = 0; i < count; ++i) {
+            if (contacts[i].normal.x != 0.f) ++gridSideContacts;
+        }
+    }
+    int cellsCrossed = (int)((slider.getPosition().x - tileSize) / tileSize);
+    bool caught = slider.sideContacts > 0 || gridSideContacts > 0;
+    std::cout << "  Seams: " << cellsCrossed << " cells crossed in " << seamSteps << " steps, on the ground for " << slider.groundContacts
+        << ", " << slider.sideContacts << " sideways contacts, " << gridSideContacts << " sideways grid contacts"
+        << (caught ? " CAUGHT ON A SEAM" : "") << "\n";
+    world.RemoveGameObject(slider);
+}
@@ -0,0 +1,43 @@
+// Benchmark Class
+// Timing helpers for comparing the physics code paths on synthetic scenes.
+// Run the game with the --benchmark argument to print the results to the console instead of opening the window.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+
+class Benchmark
+{
+public:
+	// Runs every benchmark below with the standard body counts
+	static void run();
+
+	// Compares the brute force pair loop with the spatial hash, sweep and prune and AABB tree broadphases.
+	// Boxes are laid out along a long side scrolling level and moved a little every step.
+	static void broadphase(int bodyCount, int steps = 20);
+
+	// Tests query boxes against every box of a level one at a time with sf::FloatRect::intersects,
+	// then with the box batch kernels at each SIMD level the CPU supports
+	static void overlapKernel(int boxCount, int queries = 1000);
+
+	// Steps a world of crowded boxes falling onto a floor with 1, 2, 4... threads up to the core count.
+	// Also checks every thread count ends with the same positions as the single threaded run.
+	static void narrowphase(int bodyCount, int steps = 20);
+
+	// Casts short line of sight rays across a level with World::raycastBatch, compared with testing every object for every ray
+	static void raycast(int bodyCount, int rayCount = 500);
+
+	// Picks the tile under random mouse positions with World::queryPoint, compared with checking every tile like the editor used to
+	static void picking(int tileCount, int clicks = 1000);
+
+	// Times the narrowphase routine for every pair of collider types on randomly placed and rotated pairs, many of them touching
+	static void colliders(int pairCount);
+
+	// Steps the same falling boxes on terrain built from a TileMap, as a CollisionGrid and as one static object per solid tile.
+	// Also drives a box along the ground and checks the seams between cells never push it sideways
+	static void collisionGrid(int tileCount, int steps = 20);
+
+private:
+	static std::vector<sf::FloatRect> makeLevel(int bodyCount, unsigned int seed);
+	static void jitter(std::vector<sf::FloatRect>& boxes, unsigned int& seed);
+};
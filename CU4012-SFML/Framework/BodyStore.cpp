@@ -0,0 +1,252 @@
+#include "BodyStore.h"
+#include "GameObject.h"
+#include <limits>
+
+BodyStore::BodyStore()
+{
+    live = false;
+}
+
+void BodyStore::add(GameObject* obj)
+{
+    obj->bodyStore = this;
+    obj->storeIndex = (int)owners.size();
+    owners.push_back(obj);
+
+    positionX.push_back(0.f);
+    positionY.push_back(0.f);
+    previousX.push_back(0.f);
+    previousY.push_back(0.f);
+    velocityX.push_back(0.f);
+    velocityY.push_back(0.f);
+    inverseMass.push_back(0.f);
+    gravityScale.push_back(0.f);
+    fallLimit.push_back(0.f);
+    offsetX.push_back(0.f);
+    offsetY.push_back(0.f);
+    width.push_back(0.f);
+    height.push_back(0.f);
+    rotation.push_back(0.f);
+    angularVelocity.push_back(0.f);
+    torque.push_back(0.f);
+    sleepTime.push_back(0.f);
+
+    pullBody(obj->storeIndex);
+}
+
+void BodyStore::remove(GameObject* obj)
+{
+    int i = indexOf(obj);
+    if (i == -1) return;
+
+    if (live) {
+        pushBody(i);
+    }
+
+    // Move the last body into the gap
+    int last = (int)owners.size() - 1;
+    if (i != last) {
+        owners[i] = owners[last];
+        owners[i]->storeIndex = i;
+        positionX[i] = positionX[last];
+        positionY[i] = positionY[last];
+        previousX[i] = previousX[last];
+        previousY[i] = previousY[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        inverseMass[i] = inverseMass[last];
+        gravityScale[i] = gravityScale[last];
+        fallLimit[i] = fallLimit[last];
+        offsetX[i] = offsetX[last];
+        offsetY[i] = offsetY[last];
+        width[i] = width[last];
+        height[i] = height[last];
+        rotation[i] = rotation[last];
+        angularVelocity[i] = angularVelocity[last];
+        torque[i] = torque[last];
+        sleepTime[i] = sleepTime[last];
+    }
+
+    owners.pop_back();
+    positionX.pop_back();
+    positionY.pop_back();
+    previousX.pop_back();
+    previousY.pop_back();
+    velocityX.pop_back();
+    velocityY.pop_back();
+    inverseMass.pop_back();
+    gravityScale.pop_back();
+    fallLimit.pop_back();
+    offsetX.pop_back();
+    offsetY.pop_back();
+    width.pop_back();
+    height.pop_back();
+    rotation.pop_back();
+    angularVelocity.pop_back();
+    torque.pop_back();
+    sleepTime.pop_back();
+
+    obj->bodyStore = nullptr;
+    obj->storeIndex = -1;
+}
+
+void BodyStore::clear()
+{
+    for (int i = 0; i < (int)owners.size(); ++i) {
+        if (live) {
+            pushBody(i);
+        }
+        owners[i]->bodyStore = nullptr;
+        owners[i]->storeIndex = -1;
+    }
+
+    owners.clear();
+    positionX.clear();
+    positionY.clear();
+    previousX.clear();
+    previousY.clear();
+    velocityX.clear();
+    velocityY.clear();
+    inverseMass.clear();
+    gravityScale.clear();
+    fallLimit.clear();
+    offsetX.clear();
+    offsetY.clear();
+    width.clear();
+    height.clear();
+    rotation.clear();
+    angularVelocity.clear();
+    torque.clear();
+    sleepTime.clear();
+}
+
+void BodyStore::setGravity(sf::Vector2f g)
+{
+    gravity = g;
+    for (int i = 0; i < (int)owners.size(); ++i) {
+        if (fallLimit[i] != std::numeric_limits<float>::infinity()) {
+            fallLimit[i] = gravity.y;
+        }
+    }
+}
+
+int BodyStore::indexOf(const GameObject* obj) const
+{
+    return obj->bodyStore == this ? obj->storeIndex : -1;
+}
+
+void BodyStore::pull()
+{
+    for (int i = 0; i < (int)owners.size(); ++i) {
+        pullBody(i);
+    }
+    live = true;
+}
+
+void BodyStore::push()
+{
+    for (int i = 0; i < (int)owners.size(); ++i) {
+        pushBody(i);
+    }
+    live = false;
+}
+
+void BodyStore::pullBody(int i)
+{
+    GameObject* obj = owners[i];
+    sf::Vector2f position = obj->getPosition();
+    positionX[i] = position.x;
+    positionY[i] = position.y;
+    previousX[i] = obj->previousPosition.x;
+    previousY[i] = obj->previousPosition.y;
+    velocityX[i] = obj->velocity.x;
+    velocityY[i] = obj->velocity.y;
+    inverseMass[i] = obj->getInverseMass();
+    gravityScale[i] = obj->isMassless ? 0.f : 1.f;
+    fallLimit[i] = (obj->isMassless || obj->isBullet) ? std::numeric_limits<float>::infinity() : gravity.y;
+    sf::Vector2f size = obj->customCollisionBox ? obj->collisionSize : obj->getSize();
+    offsetX[i] = obj->collisionOffset.x;
+    offsetY[i] = obj->collisionOffset.y;
+    width[i] = size.x;
+    height[i] = size.y;
+    rotation[i] = obj->getRotation();
+    angularVelocity[i] = obj->angularVelocity;
+    torque[i] = obj->torque;
+}
+
+void BodyStore::pushBody(int i)
+{
+    GameObject* obj = owners[i];
+
+    // Only touch the transform if the body moved, each set invalidates SFML's cached transform
+    sf::Vector2f position(positionX[i], positionY[i]);
+    if (obj->getPosition() != position) {
+        obj->setPosition(position);
+    }
+    if (obj->getRotation() != rotation[i]) {
+        obj->setRotation(rotation[i]);
+    }
+    obj->previousPosition = sf::Vector2f(previousX[i], previousY[i]);
+    obj->velocity = sf::Vector2f(velocityX[i], velocityY[i]);
+    obj->angularVelocity = angularVelocity[i];
+    obj->setDebugCollisionBox(obj->collisionBox.left, obj->collisionBox.top, obj->collisionBox.width, obj->collisionBox.height);
+}
+
+// Every array is separate, __restrict tells the compiler so it can vectorise the loop without checking for overlap.
+// A free function as compilers only reliably honour __restrict on parameters
+static void integrateBodies(int count, float deltaTime, float gravityStep,
+    float* __restrict px, float* __restrict py, float* __restrict prevX, float* __restrict prevY,
+    float* __restrict vx, float* __restrict vy, const float* __restrict scale, const float* __restrict limit,
+    float* __restrict angle, float* __restrict spin, const float* __restrict spinUp)
+{
+    for (int i = 0; i < count; ++i) {
+        prevX[i] = px[i];
+        prevY[i] = py[i];
+
+        // Clamp the fall speed so bodies do not fall through the floor, bullets and massless bodies have no limit
+        float fall = vy[i] + gravityStep * scale[i];
+        vy[i] = fall < limit[i] ? fall : limit[i];
+
+        spin[i] += spinUp[i] * deltaTime;
+        angle[i] += spin[i] * deltaTime;
+        px[i] += vx[i] * deltaTime;
+        py[i] += vy[i] * deltaTime;
+    }
+}
+
+void BodyStore::integrate(float deltaTime)
+{
+    integrateBodies((int)owners.size(), deltaTime, gravity.y * deltaTime,
+        positionX.data(), positionY.data(), previousX.data(), previousY.data(),
+        velocityX.data(), velocityY.data(), gravityScale.data(), fallLimit.data(),
+        rotation.data(), angularVelocity.data(), torque.data());
+}
+
+void BodyStore::updateSleepTimes(float deltaTime, float speed)
+{
+    const int count = (int)owners.size();
+    const float* vx = velocityX.data();
+    const float* vy = velocityY.data();
+    float* time = sleepTime.data();
+    const float limit = speed * speed;
+    for (int i = 0; i < count; ++i) {
+        float speedSquared = vx[i] * vx[i] + vy[i] * vy[i];
+        time[i] = speedSquared < limit ? time[i] + deltaTime : 0.f;
+    }
+}
+
+void BodyStore::writeBoxes()
+{
+    for (int i = 0; i < (int)owners.size(); ++i) {
+        owners[i]->collisionBox = sf::FloatRect(positionX[i] + offsetX[i], positionY[i] + offsetY[i], width[i], height[i]);
+        owners[i]->placeCollider(rotation[i]);
+    }
+}
+
+void BodyStore::translate(int i, sf::Vector2f delta)
+{
+    move(i, delta);
+    owners[i]->collisionBox.left += delta.x;
+    owners[i]->collisionBox.top += delta.y;
+    owners[i]->colliderTransform.position += delta;
+}
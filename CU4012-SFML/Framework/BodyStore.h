@@ -0,0 +1,83 @@
+// Body Store Class
+// The physics state of the world's moving objects in structure of arrays form: position, velocity, inverse mass, box size and flags
+// each in their own contiguous array. The world steps these arrays rather than the objects, so integration is one tight loop
+// the compiler can vectorise, and SFML's transforms are not touched every step.
+// State is pulled from the objects before a frame's steps and pushed back to them once after, see World::UpdateFixed.
+// While the store is live (between the two) it holds the current state and the objects' velocity accessors go through it.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+
+class GameObject;
+
+class BodyStore
+{
+public:
+	BodyStore();
+
+	// Adds a moving object, its state is copied in straight away. Objects know their index in the store
+	void add(GameObject* obj);
+	// Swaps the last body into the removed one's place. A live body's state is pushed back to it first
+	void remove(GameObject* obj);
+	void clear();
+	int size() const { return (int)owners.size(); }
+
+	// Gravity applied by integrate, objects that are not massless or bullets have their fall speed clamped to it
+	void setGravity(sf::Vector2f g);
+
+	// Copies every object's state into the arrays and makes the store live
+	void pull();
+	// Writes the state back to the objects once and ends the live period
+	void push();
+	bool isLive() const { return live; }
+
+	// Applies gravity and moves every body by its velocity, keeping the previous positions for interpolation
+	void integrate(float deltaTime);
+	// Copies the boxes to the objects' collision boxes for the broadphase and narrowphase
+	void writeBoxes();
+	// Adds the step to the time each body has been slower than the speed, resets it for faster bodies
+	void updateSleepTimes(float deltaTime, float speed);
+	float getSleepTime(int i) const { return sleepTime[i]; }
+
+	// Index of an object in the store, -1 if it is not in it
+	int indexOf(const GameObject* obj) const;
+
+	sf::Vector2f getPosition(int i) const { return sf::Vector2f(positionX[i], positionY[i]); }
+	sf::Vector2f getPreviousPosition(int i) const { return sf::Vector2f(previousX[i], previousY[i]); }
+	sf::Vector2f getVelocity(int i) const { return sf::Vector2f(velocityX[i], velocityY[i]); }
+	void setVelocity(int i, sf::Vector2f v) { velocityX[i] = v.x; velocityY[i] = v.y; }
+	float getInverseMass(int i) const { return inverseMass[i]; }
+	GameObject* getObject(int i) const { return owners[i]; }
+
+	// Moves the body only, its collision box follows at the next integrate (matches sf::Transformable::move on an object)
+	void move(int i, sf::Vector2f delta) { positionX[i] += delta.x; positionY[i] += delta.y; }
+	// Moves the body and its collision box together
+	void translate(int i, sf::Vector2f delta);
+
+private:
+	void pullBody(int i);
+	void pushBody(int i);
+
+	std::vector<GameObject*> owners;
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> previousX;
+	std::vector<float> previousY;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> inverseMass;
+	std::vector<float> gravityScale;	// 0 for massless bodies, 1 otherwise
+	std::vector<float> fallLimit;		// highest downward speed, infinite for massless bodies and bullets
+	std::vector<float> offsetX;			// box's top left relative to the position, see GameObject::setCollisionBox
+	std::vector<float> offsetY;
+	std::vector<float> width;			// box size
+	std::vector<float> height;
+	std::vector<float> rotation;
+	std::vector<float> angularVelocity;
+	std::vector<float> torque;
+	std::vector<float> sleepTime;		// how long the body has been nearly still, kept by the store rather than pulled
+
+	sf::Vector2f gravity;
+	bool live;
+};
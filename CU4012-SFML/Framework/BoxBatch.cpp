@@ -0,0 +1,208 @@
+#include "BoxBatch.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BOXBATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX intrinsics in any function, other compilers need the function marked for AVX2
+#define BOXBATCH_AVX2_TARGET
+#else
+#define BOXBATCH_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Lanes are padded to this many boxes so the widest kernel can always load a full block
+static const int padding = 8;
+
+BoxBatch::Bounds::Bounds(const sf::FloatRect& box)
+{
+    minX = std::min(box.left, box.left + box.width);
+    maxX = std::max(box.left, box.left + box.width);
+    minY = std::min(box.top, box.top + box.height);
+    maxY = std::max(box.top, box.top + box.height);
+}
+
+BoxBatch::BoxBatch()
+{
+    count = 0;
+    level = getSupportedLevel();
+}
+
+SimdLevel BoxBatch::getSupportedLevel()
+{
+#ifdef BOXBATCH_X86
+    static const SimdLevel supported = []() {
+#ifdef _MSC_VER
+        // AVX2 needs the CPU flag and the OS saving the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return SimdLevel::SSE2;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return SimdLevel::SSE2;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#endif
+    }();
+    return supported;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+void BoxBatch::setLevel(SimdLevel l)
+{
+    level = std::min(l, getSupportedLevel());
+}
+
+int BoxBatch::add(const sf::FloatRect& box)
+{
+    // Grow by a whole block of empty boxes, min above max never overlaps anything
+    if (count == (int)minX.size()) {
+        const float inf = std::numeric_limits<float>::infinity();
+        minX.resize(count + padding, inf);
+        minY.resize(count + padding, inf);
+        maxX.resize(count + padding, -inf);
+        maxY.resize(count + padding, -inf);
+    }
+    set(count, box);
+    return count++;
+}
+
+void BoxBatch::set(int index, const sf::FloatRect& box)
+{
+    Bounds bounds(box);
+    minX[index] = bounds.minX;
+    minY[index] = bounds.minY;
+    maxX[index] = bounds.maxX;
+    maxY[index] = bounds.maxY;
+}
+
+void BoxBatch::remove(int index)
+{
+    int last = count - 1;
+    minX[index] = minX[last];
+    minY[index] = minY[last];
+    maxX[index] = maxX[last];
+    maxY[index] = maxY[last];
+
+    // The freed lane goes back to an empty box, the kernels read it as part of the last block
+    const float inf = std::numeric_limits<float>::infinity();
+    minX[last] = inf;
+    minY[last] = inf;
+    maxX[last] = -inf;
+    maxY[last] = -inf;
+    --count;
+}
+
+void BoxBatch::clear()
+{
+    minX.clear();
+    minY.clear();
+    maxX.clear();
+    maxY.clear();
+    count = 0;
+}
+
+// Overlap if the intersection is non empty on both axes, the same test as sf::FloatRect::intersects.
+// Points use an inclusive test so clicking exactly on an edge still picks the box
+unsigned int BoxBatch::maskScalar(const Bounds& box, int first, int lanes, bool inclusive) const
+{
+    unsigned int mask = 0;
+    for (int i = 0; i < lanes; ++i) {
+        int index = first + i;
+        float left = std::max(box.minX, minX[index]);
+        float right = std::min(box.maxX, maxX[index]);
+        float top = std::max(box.minY, minY[index]);
+        float bottom = std::min(box.maxY, maxY[index]);
+        bool hit = inclusive ? (left <= right && top <= bottom) : (left < right && top < bottom);
+        if (hit) mask |= 1u << i;
+    }
+    return mask;
+}
+
+unsigned int BoxBatch::maskSSE2(const Bounds& box, int first, bool inclusive) const
+{
+#ifdef BOXBATCH_X86
+    __m128 left = _mm_max_ps(_mm_set1_ps(box.minX), _mm_loadu_ps(&minX[first]));
+    __m128 right = _mm_min_ps(_mm_set1_ps(box.maxX), _mm_loadu_ps(&maxX[first]));
+    __m128 top = _mm_max_ps(_mm_set1_ps(box.minY), _mm_loadu_ps(&minY[first]));
+    __m128 bottom = _mm_min_ps(_mm_set1_ps(box.maxY), _mm_loadu_ps(&maxY[first]));
+    __m128 hit = inclusive
+        ? _mm_and_ps(_mm_cmple_ps(left, right), _mm_cmple_ps(top, bottom))
+        : _mm_and_ps(_mm_cmplt_ps(left, right), _mm_cmplt_ps(top, bottom));
+    return (unsigned int)_mm_movemask_ps(hit);
+#else
+    return maskScalar(box, first, 4, inclusive);
+#endif
+}
+
+#ifdef BOXBATCH_X86
+BOXBATCH_AVX2_TARGET static unsigned int maskAVX2Kernel(const float* minX, const float* minY, const float* maxX, const float* maxY,
+    float boxMinX, float boxMinY, float boxMaxX, float boxMaxY, bool inclusive)
+{
+    __m256 left = _mm256_max_ps(_mm256_set1_ps(boxMinX), _mm256_loadu_ps(minX));
+    __m256 right = _mm256_min_ps(_mm256_set1_ps(boxMaxX), _mm256_loadu_ps(maxX));
+    __m256 top = _mm256_max_ps(_mm256_set1_ps(boxMinY), _mm256_loadu_ps(minY));
+    __m256 bottom = _mm256_min_ps(_mm256_set1_ps(boxMaxY), _mm256_loadu_ps(maxY));
+    __m256 hit = inclusive
+        ? _mm256_and_ps(_mm256_cmp_ps(left, right, _CMP_LE_OQ), _mm256_cmp_ps(top, bottom, _CMP_LE_OQ))
+        : _mm256_and_ps(_mm256_cmp_ps(left, right, _CMP_LT_OQ), _mm256_cmp_ps(top, bottom, _CMP_LT_OQ));
+    return (unsigned int)_mm256_movemask_ps(hit);
+}
+#endif
+
+unsigned int BoxBatch::maskAVX2(const Bounds& box, int first, bool inclusive) const
+{
+#ifdef BOXBATCH_X86
+    return maskAVX2Kernel(&minX[first], &minY[first], &maxX[first], &maxY[first], box.minX, box.minY, box.maxX, box.maxY, inclusive);
+#else
+    return maskScalar(box, first, 8, inclusive);
+#endif
+}
+
+unsigned int BoxBatch::overlapMask4(const sf::FloatRect& box, int first) const
+{
+    if (level == SimdLevel::Scalar) return maskScalar(Bounds(box), first, 4, false);
+    return maskSSE2(Bounds(box), first, false);
+}
+
+unsigned int BoxBatch::overlapMask8(const sf::FloatRect& box, int first) const
+{
+    if (level == SimdLevel::AVX2) return maskAVX2(Bounds(box), first, false);
+    if (level == SimdLevel::SSE2) return maskSSE2(Bounds(box), first, false) | (maskSSE2(Bounds(box), first + 4, false) << 4);
+    return maskScalar(Bounds(box), first, 8, false);
+}
+
+void BoxBatch::query(const sf::FloatRect& box, std::vector<int>& results) const
+{
+    forEachHit(Bounds(box), false, [&results](int index) {
+        results.push_back(index);
+        return true;
+    });
+}
+
+void BoxBatch::queryPoint(sf::Vector2f point, std::vector<int>& results) const
+{
+    forEachHit(Bounds(point), true, [&results](int index) {
+        results.push_back(index);
+        return true;
+    });
+}
+
+int BoxBatch::findPoint(sf::Vector2f point) const
+{
+    int found = -1;
+    forEachHit(Bounds(point), true, [&found](int index) {
+        found = index;
+        return false;
+    });
+    return found;
+}
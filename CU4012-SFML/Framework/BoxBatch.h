@@ -0,0 +1,90 @@
+// Box Batch Class
+// Stores many axis aligned boxes as separate min/max arrays (structure of arrays) so one box can be tested against
+// 4 of them at once with SSE2, or 8 at once with AVX2 when the CPU supports it. Each test returns a bitmask of the hits.
+// The overlap test matches sf::FloatRect::intersects and the point test matches Collision::checkBoundingBox.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+#include <cstdint>
+
+// Instruction sets the kernels can use, picked at runtime from what the CPU supports
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+class BoxBatch
+{
+public:
+	BoxBatch();
+
+	// Adds a box and returns its index, indices run in the order the boxes were added
+	int add(const sf::FloatRect& box);
+	void set(int index, const sf::FloatRect& box);
+	// Moves the last box into the index, matching a swap removal from the list the boxes mirror
+	void remove(int index);
+	void clear();
+	int getCount() const { return count; }
+
+	// Best level this CPU supports, checked once
+	static SimdLevel getSupportedLevel();
+	// Forces a lower level, used by the benchmarks to compare the paths. Levels the CPU lacks fall back to the best supported one
+	void setLevel(SimdLevel l);
+	SimdLevel getLevel() const { return level; }
+
+	// Appends the index of every box overlapping the box, in ascending order
+	void query(const sf::FloatRect& box, std::vector<int>& results) const;
+	// Appends the index of every box containing the point (edges included), in ascending order
+	void queryPoint(sf::Vector2f point, std::vector<int>& results) const;
+	// Index of the first box containing the point, or -1
+	int findPoint(sf::Vector2f point) const;
+
+	// Tests the box against boxes [first, first + 4) or [first, first + 8), bit i of the result is set if box first + i overlaps.
+	// first must be a multiple of the lane count, lanes past the end never hit
+	unsigned int overlapMask4(const sf::FloatRect& box, int first) const;
+	unsigned int overlapMask8(const sf::FloatRect& box, int first) const;
+
+private:
+	// Box as min/max corners, negative sizes are allowed as they are by sf::FloatRect
+	struct Bounds
+	{
+		float minX, minY, maxX, maxY;
+		Bounds(const sf::FloatRect& box);
+		Bounds(sf::Vector2f point) : minX(point.x), minY(point.y), maxX(point.x), maxY(point.y) {}
+	};
+
+	template <typename T>
+	void forEachHit(const Bounds& box, bool inclusive, T&& callback) const;
+
+	unsigned int maskScalar(const Bounds& box, int first, int lanes, bool inclusive) const;
+	unsigned int maskSSE2(const Bounds& box, int first, bool inclusive) const;
+	unsigned int maskAVX2(const Bounds& box, int first, bool inclusive) const;
+
+	// Padded to a multiple of 8 with empty boxes (min above max) so the kernels never read past the end
+	std::vector<float> minX;
+	std::vector<float> minY;
+	std::vector<float> maxX;
+	std::vector<float> maxY;
+	int count;
+	SimdLevel level;
+};
+
+template <typename T>
+void BoxBatch::forEachHit(const Bounds& box, bool inclusive, T&& callback) const
+{
+	int lanes = (level == SimdLevel::AVX2) ? 8 : 4;
+	for (int first = 0; first < count; first += lanes)
+	{
+		unsigned int mask;
+		if (level == SimdLevel::AVX2) mask = maskAVX2(box, first, inclusive);
+		else if (level == SimdLevel::SSE2) mask = maskSSE2(box, first, inclusive);
+		else mask = maskScalar(box, first, lanes, inclusive);
+
+		// Visit the set bits lowest first so indices come out in order
+		while (mask)
+		{
+			int lane = 0;
+			while (!(mask & (1u << lane))) ++lane;
+			mask &= mask - 1;
+			if (!callback(first + lane)) return;
+		}
+	}
+}
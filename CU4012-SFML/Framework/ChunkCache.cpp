@@ -0,0 +1,227 @@
+#include "ChunkCache.h"
+#include <cmath>
+
+ChunkCache::ChunkCache()
+{
+    chunkSize = 512;
+    maxChunks = 48;
+    updateCount = 0;
+    frame = 0;
+    drawCalls = 0;
+    visibleChunks = 0;
+    bakes = 0;
+}
+
+void ChunkCache::setChunkSize(unsigned int size)
+{
+    chunkSize = size;
+    clear();
+}
+
+void ChunkCache::clear()
+{
+    chunks.clear();
+    records.clear();
+    slots.clear();
+}
+
+int ChunkCache::getBakedCount() const
+{
+    int count = 0;
+    for (auto& slot : slots) {
+        if (slot.used) ++count;
+    }
+    return count;
+}
+
+void ChunkCache::getCellRange(const sf::FloatRect& area, int& x0, int& y0, int& x1, int& y1) const
+{
+    float size = (float)chunkSize;
+    x0 = (int)std::floor(area.left / size);
+    y0 = (int)std::floor(area.top / size);
+    x1 = (int)std::floor((area.left + area.width) / size);
+    y1 = (int)std::floor((area.top + area.height) / size);
+}
+
+void ChunkCache::invalidate(const sf::FloatRect& area)
+{
+    int x0, y0, x1, y1;
+    getCellRange(area, x0, y0, x1, y1);
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            auto it = chunks.find(keyOf(x, y));
+            if (it != chunks.end()) {
+                it->second.dirty = true;
+            }
+        }
+    }
+}
+
+void ChunkCache::update(const std::vector<const sf::RectangleShape*>& tiles)
+{
+    ++updateCount;
+
+    // Chunk tile lists are rebuilt from scratch, it is only pointers. Baking is what costs and that is limited to the chunks that changed
+    for (auto& entry : chunks) {
+        entry.second.tiles.clear();
+    }
+
+    for (const sf::RectangleShape* tile : tiles) {
+        TileRecord current;
+        current.bounds = tile->getTransform().transformRect(sf::FloatRect(sf::Vector2f(0.f, 0.f), tile->getSize()));
+        current.texture = tile->getTexture();
+        current.textureRect = tile->getTextureRect();
+        current.colour = tile->getFillColor();
+        current.seen = updateCount;
+
+        auto it = records.find(tile);
+        if (it == records.end()) {
+            records.emplace(tile, current);
+        }
+        else {
+            TileRecord& previous = it->second;
+            if (previous.bounds != current.bounds || previous.texture != current.texture ||
+                previous.textureRect != current.textureRect || previous.colour != current.colour) {
+                invalidate(previous.bounds);
+                invalidate(current.bounds);
+            }
+            previous = current;
+        }
+
+        // A tile across a chunk border is drawn into every chunk it touches, each clips it to its own square
+        int x0, y0, x1, y1;
+        getCellRange(current.bounds, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                Chunk& chunk = chunks[keyOf(x, y)];
+                chunk.x = x;
+                chunk.y = y;
+                chunk.tiles.push_back(tile);
+            }
+        }
+    }
+
+    // Tiles that are gone leave a hole in the chunks they were in
+    for (auto it = records.begin(); it != records.end();) {
+        if (it->second.seen != updateCount) {
+            invalidate(it->second.bounds);
+            it = records.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Drop chunks with nothing left in them, giving their render texture back to the pool
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        if (it->second.tiles.empty()) {
+            if (it->second.slot != -1) {
+                slots[it->second.slot].used = false;
+            }
+            it = chunks.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+int ChunkCache::acquireSlot(long long key)
+{
+    // A free texture first, then a new one while under the limit
+    for (int i = 0; i < (int)slots.size(); ++i) {
+        if (!slots[i].used) {
+            slots[i].chunk = key;
+            slots[i].used = true;
+            return i;
+        }
+    }
+    if ((int)slots.size() < maxChunks) {
+        auto texture = std::make_unique<sf::RenderTexture>();
+        if (!texture->create(chunkSize, chunkSize)) {
+            return -1;
+        }
+        slots.push_back({ std::move(texture), key, true });
+        return (int)slots.size() - 1;
+    }
+
+    // Otherwise take the texture of the chunk drawn longest ago, as long as it is not on screen this frame
+    int oldest = -1;
+    unsigned int oldestFrame = frame;
+    for (int i = 0; i < (int)slots.size(); ++i) {
+        const Chunk& owner = chunks.at(slots[i].chunk);
+        if (owner.lastDrawn < oldestFrame) {
+            oldestFrame = owner.lastDrawn;
+            oldest = i;
+        }
+    }
+    if (oldest != -1) {
+        chunks.at(slots[oldest].chunk).slot = -1;
+        slots[oldest].chunk = key;
+    }
+    return oldest;
+}
+
+void ChunkCache::bake(Chunk& chunk)
+{
+    sf::RenderTexture& texture = *slots[chunk.slot].texture;
+    float size = (float)chunkSize;
+    texture.setView(sf::View(sf::FloatRect(chunk.x * size, chunk.y * size, size, size)));
+    texture.clear(sf::Color::Transparent);
+    for (const sf::RectangleShape* tile : chunk.tiles) {
+        texture.draw(*tile);
+    }
+    texture.display();
+    chunk.dirty = false;
+    ++bakes;
+}
+
+void ChunkCache::draw(sf::RenderTarget& target)
+{
+    ++frame;
+    drawCalls = 0;
+    visibleChunks = 0;
+    bakes = 0;
+
+    // The area the view shows, its zoom and rotation included
+    sf::FloatRect viewBounds = target.getView().getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+    int x0, y0, x1, y1;
+    getCellRange(viewBounds, x0, y0, x1, y1);
+    float size = (float)chunkSize;
+
+    // Mark everything in view as drawn first, so baking one chunk on screen never takes the texture of another chunk on screen
+    visible.clear();
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            auto it = chunks.find(keyOf(x, y));
+            if (it == chunks.end()) continue;
+            it->second.lastDrawn = frame;
+            visible.push_back(it->first);
+        }
+    }
+    visibleChunks = (int)visible.size();
+
+    for (long long key : visible) {
+        Chunk& chunk = chunks.at(key);
+        if (chunk.slot == -1) {
+            chunk.slot = acquireSlot(key);
+            chunk.dirty = true;
+        }
+        if (chunk.slot == -1) {
+            // More chunks on screen than textures, draw this one's tiles straight to the target instead
+            for (const sf::RectangleShape* tile : chunk.tiles) {
+                target.draw(*tile);
+                ++drawCalls;
+            }
+            continue;
+        }
+        if (chunk.dirty) {
+            bake(chunk);
+        }
+
+        sf::Sprite sprite(slots[chunk.slot].texture->getTexture());
+        sprite.setPosition(chunk.x * size, chunk.y * size);
+        target.draw(sprite);
+        ++drawCalls;
+    }
+}
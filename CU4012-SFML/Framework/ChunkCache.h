@@ -0,0 +1,83 @@
+// Chunk Cache Class
+// Bakes static tiles into render textures so they are not redrawn tile by tile every frame. The world is split into square chunks,
+// and the first time a chunk comes into view its tiles are drawn once into a render texture. After that the chunk is one textured quad.
+// When the tiles change only the chunks they were in or moved into are baked again. Render textures are pooled, and once the pool is
+// full the least recently drawn chunk gives up its texture, so memory stays bounded however big the level is.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ChunkCache
+{
+public:
+	ChunkCache();
+
+	// Chunk size in world units, which is also the size of each render texture in pixels. Changing it empties the cache
+	void setChunkSize(unsigned int size);
+	unsigned int getChunkSize() const { return chunkSize; }
+	// Most render textures kept at once
+	void setMaxChunks(int count) { maxChunks = count; }
+	int getMaxChunks() const { return maxChunks; }
+
+	// Brings the cache up to date with the tiles, in the order they should be drawn. Chunks are only marked for baking again if a tile
+	// in them moved, resized, changed texture or colour, or was added or removed
+	void update(const std::vector<const sf::RectangleShape*>& tiles);
+	void clear();
+
+	// Draws the chunks in the target's view, baking any that need it first
+	void draw(sf::RenderTarget& target);
+
+	int getChunkCount() const { return (int)chunks.size(); }
+	int getBakedCount() const;
+	// What the last draw did
+	int getDrawCalls() const { return drawCalls; }
+	int getVisibleChunkCount() const { return visibleChunks; }
+	int getBakeCount() const { return bakes; }
+
+private:
+	struct Chunk
+	{
+		int x, y;
+		std::vector<const sf::RectangleShape*> tiles;
+		int slot = -1;			// render texture holding the chunk, -1 if it is not baked
+		bool dirty = true;		// the render texture is out of date
+		unsigned int lastDrawn = 0;
+	};
+	struct Slot
+	{
+		std::unique_ptr<sf::RenderTexture> texture;
+		long long chunk = 0;	// key of the chunk using it, any value is a valid key so only read it while used
+		bool used = false;
+	};
+	// What a tile looked like when the cache last saw it
+	struct TileRecord
+	{
+		sf::FloatRect bounds;
+		const sf::Texture* texture;
+		sf::IntRect textureRect;
+		sf::Color colour;
+		unsigned int seen;
+	};
+
+	long long keyOf(int x, int y) const { return (long long)(((unsigned long long)(unsigned int)x << 32) | (unsigned int)y); }
+	void getCellRange(const sf::FloatRect& area, int& x0, int& y0, int& x1, int& y1) const;
+	void invalidate(const sf::FloatRect& area);
+	int acquireSlot(long long key);
+	void bake(Chunk& chunk);
+
+	std::unordered_map<long long, Chunk> chunks;
+	std::unordered_map<const sf::RectangleShape*, TileRecord> records;
+	std::vector<Slot> slots;
+	std::vector<long long> visible;
+	unsigned int chunkSize;
+	int maxChunks;
+	unsigned int updateCount;
+	unsigned int frame;
+
+	int drawCalls;
+	int visibleChunks;
+	int bakes;
+};
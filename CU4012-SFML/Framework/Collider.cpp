@@ -0,0 +1,98 @@
+#include "Collider.h"
+#include <algorithm>
+
+Collider Collider::box()
+{
+    return Collider();
+}
+
+Collider Collider::circle(float radius)
+{
+    Collider collider;
+    collider.type = Type::Circle;
+    collider.radius = radius;
+    collider.vertexCount = 1;
+    return collider;
+}
+
+Collider Collider::capsule(sf::Vector2f a, sf::Vector2f b, float radius)
+{
+    Collider collider;
+    collider.type = Type::Capsule;
+    collider.radius = radius;
+    collider.vertexCount = 2;
+    collider.vertices[0] = a;
+    collider.vertices[1] = b;
+    collider.computeNormals();
+    return collider;
+}
+
+Collider Collider::orientedBox(sf::Vector2f halfSize)
+{
+    sf::Vector2f corners[4] = {
+        sf::Vector2f(-halfSize.x, -halfSize.y), sf::Vector2f(halfSize.x, -halfSize.y),
+        sf::Vector2f(halfSize.x, halfSize.y), sf::Vector2f(-halfSize.x, halfSize.y)
+    };
+    Collider collider = polygon(corners, 4);
+    collider.type = Type::OrientedBox;
+    return collider;
+}
+
+Collider Collider::polygon(const sf::Vector2f* points, int count)
+{
+    Collider collider;
+    collider.type = Type::Polygon;
+    collider.vertexCount = std::min(count, maxVertices);
+    for (int i = 0; i < collider.vertexCount; ++i) {
+        collider.vertices[i] = points[i];
+    }
+    collider.computeNormals();
+    return collider;
+}
+
+// Normals are found once here so the narrowphase only has to rotate them. A capsule's line gets one normal for each side
+void Collider::computeNormals()
+{
+    sf::Vector2f centre;
+    for (int i = 0; i < vertexCount; ++i) {
+        centre += vertices[i];
+    }
+    centre /= (float)std::max(vertexCount, 1);
+
+    for (int i = 0; i < vertexCount; ++i) {
+        sf::Vector2f edge = vertices[(i + 1) % vertexCount] - vertices[i];
+        float length = std::sqrt(edge.x * edge.x + edge.y * edge.y);
+        sf::Vector2f normal = length > 0.f ? sf::Vector2f(edge.y / length, -edge.x / length) : sf::Vector2f(0.f, -1.f);
+
+        // Outward whatever the winding, the centre of a convex shape is on the inside of every edge
+        sf::Vector2f toCentre = centre - vertices[i];
+        if (normal.x * toCentre.x + normal.y * toCentre.y > 0.f) {
+            normal = -normal;
+        }
+        normals[i] = normal;
+    }
+
+    // The two normals of a line are both taken from the first end, make the second one face the other way
+    if (vertexCount == 2) {
+        normals[1] = -normals[0];
+    }
+}
+
+sf::FloatRect Collider::getBounds(const ColliderTransform& transform) const
+{
+    if (vertexCount == 0) {
+        return sf::FloatRect(transform.position.x, transform.position.y, 0.f, 0.f);
+    }
+
+    sf::Vector2f first = transform.apply(vertices[0]);
+    sf::Vector2f min = first;
+    sf::Vector2f max = first;
+    for (int i = 1; i < vertexCount; ++i) {
+        sf::Vector2f p = transform.apply(vertices[i]);
+        min.x = std::min(min.x, p.x);
+        min.y = std::min(min.y, p.y);
+        max.x = std::max(max.x, p.x);
+        max.y = std::max(max.y, p.y);
+    }
+    return sf::FloatRect(min.x - radius, min.y - radius, max.x - min.x + radius * 2.f, max.y - min.y + radius * 2.f);
+}
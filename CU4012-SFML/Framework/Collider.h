@@ -0,0 +1,65 @@
+// Collider Class
+// The shape of a GameObject's collider. Box is the object's axis aligned collision box and is what every object has by default.
+// Circle, capsule, oriented box and convex polygon colliders are given in local space around the centre of the collision box
+// and turn with the object's rotation, see GameObject::setCollider. Colliders hold their points inline, so copying one never allocates.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <cmath>
+
+// Where a shape is in the world: the centre of the collider and its rotation as a cosine and sine
+struct ColliderTransform
+{
+	sf::Vector2f position;
+	float c = 1.f;
+	float s = 0.f;
+
+	ColliderTransform() {}
+	// Rotation in degrees, like sf::Transformable::getRotation
+	ColliderTransform(sf::Vector2f p, float degrees)
+		: position(p)
+	{
+		float radians = degrees * 3.14159265f / 180.f;
+		c = std::cos(radians);
+		s = std::sin(radians);
+	}
+
+	sf::Vector2f apply(sf::Vector2f v) const { return sf::Vector2f(c * v.x - s * v.y + position.x, s * v.x + c * v.y + position.y); }
+	sf::Vector2f rotate(sf::Vector2f v) const { return sf::Vector2f(c * v.x - s * v.y, s * v.x + c * v.y); }
+};
+
+struct Collider
+{
+	enum class Type { Box, Circle, Capsule, OrientedBox, Polygon, Count };
+
+	static const int maxVertices = 8;
+
+	Type type = Type::Box;
+	float radius = 0.f;				// circles and capsules
+	int vertexCount = 0;			// capsule end points, oriented box corners or polygon points
+	sf::Vector2f vertices[maxVertices];
+	sf::Vector2f normals[maxVertices];	// outward normal of the edge from each vertex to the next
+
+	// The object's collision box, ignores the rotation
+	static Collider box();
+	static Collider circle(float radius);
+	// Line from a to b with rounded ends of the radius
+	static Collider capsule(sf::Vector2f a, sf::Vector2f b, float radius);
+	static Collider orientedBox(sf::Vector2f halfSize);
+	// Convex polygon of up to maxVertices points in either winding, extra points are dropped
+	static Collider polygon(const sf::Vector2f* points, int count);
+
+	// Axis aligned box around the shape once it is moved into place. Not used for Box, the collision box is its bounds
+	sf::FloatRect getBounds(const ColliderTransform& transform) const;
+
+private:
+	void computeNormals();
+};
+
+// A collider moved into place, with the collision box around it. For a Box collider the box is the collider
+struct PlacedCollider
+{
+	const Collider* collider;
+	ColliderTransform transform;
+	sf::FloatRect box;
+};
@@ -1,4 +1,5 @@
 #include "Collision.h"
+#include "Narrowphase.h"
 
 // Check AABB for collision. Returns true if collision occurs.
 bool Collision::checkBoundingBox(GameObject* s1, GameObject* s2)
@@ -45,20 +46,88 @@ bool Collision::checkBoundingBox(sf::FloatRect s1, sf::Vector2i s2)
 }
 
 // Check bounding circle collision. Returns true if collision occurs.
+// Each sprite's circle is the largest that fits in it, centred on the sprite, so sizes do not have to be square
 bool Collision::checkBoundingCircle(GameObject* s1, GameObject* s2)
 {
 	// Get radius and centre of sprites.
-	float radius1 = s1->getSize().x / 2;
-	float radius2 = s2->getSize().x / 2;
-	float xpos1 = s1->getPosition().x + radius1;
-	float xpos2 = s2->getPosition().x + radius2;
-	float ypos1 = s1->getPosition().y + radius1;
-	float ypos2 = s2->getPosition().y + radius2;
+	sf::Vector2f half1 = s1->getHalfSize();
+	sf::Vector2f half2 = s2->getHalfSize();
+	float radius1 = std::min(half1.x, half1.y);
+	float radius2 = std::min(half2.x, half2.y);
 
-	if (pow(xpos2 - xpos1, 2) + pow(ypos2 - ypos1, 2) < pow(radius1 + radius2, 2))
+	sf::Vector2f normal;
+	float depth;
+	return Narrowphase::circleCircle(s1->getPosition() + half1, radius1, s2->getPosition() + half2, radius2, normal, depth);
+}
+
+// Find the axis of least overlap between two boxes, the same axis GameObject::checkCollision resolves along
+bool Collision::getPenetration(const sf::FloatRect& s1, const sf::FloatRect& s2, sf::Vector2f& normal, float& depth)
+{
+	sf::Vector2f half1(s1.width / 2.f, s1.height / 2.f);
+	sf::Vector2f half2(s2.width / 2.f, s2.height / 2.f);
+	float deltaX = (s2.left + half2.x) - (s1.left + half1.x);
+	float deltaY = (s2.top + half2.y) - (s1.top + half1.y);
+	float overlapX = (half1.x + half2.x) - std::abs(deltaX);
+	float overlapY = (half1.y + half2.y) - std::abs(deltaY);
+
+	if (overlapX <= 0.f || overlapY <= 0.f)
+		return false;
+
+	if (overlapX < overlapY)
+	{
+		normal = sf::Vector2f(deltaX > 0.f ? 1.f : -1.f, 0.f);
+		depth = overlapX;
+	}
+	else
 	{
-		return true;
+		normal = sf::Vector2f(0.f, deltaY > 0.f ? 1.f : -1.f);
+		depth = overlapY;
 	}
-	return false;
+	return true;
 }
 
+// Slab test on each axis, the boxes touch once both axes have started overlapping and before either stops
+bool Collision::sweepBoundingBox(const sf::FloatRect& s1, sf::Vector2f displacement, const sf::FloatRect& s2, float& toi, sf::Vector2f& normal)
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+	float entry[2], exit[2];
+	float min1[2] = { s1.left, s1.top };
+	float max1[2] = { s1.left + s1.width, s1.top + s1.height };
+	float min2[2] = { s2.left, s2.top };
+	float max2[2] = { s2.left + s2.width, s2.top + s2.height };
+	float d[2] = { displacement.x, displacement.y };
+
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		if (d[axis] > 0.f)
+		{
+			entry[axis] = (min2[axis] - max1[axis]) / d[axis];
+			exit[axis] = (max2[axis] - min1[axis]) / d[axis];
+		}
+		else if (d[axis] < 0.f)
+		{
+			entry[axis] = (max2[axis] - min1[axis]) / d[axis];
+			exit[axis] = (min2[axis] - max1[axis]) / d[axis];
+		}
+		else
+		{
+			// Not moving on this axis, they must already overlap on it
+			if (max1[axis] <= min2[axis] || max2[axis] <= min1[axis])
+				return false;
+			entry[axis] = -infinity;
+			exit[axis] = infinity;
+		}
+	}
+
+	float entryTime = std::max(entry[0], entry[1]);
+	float exitTime = std::min(exit[0], exit[1]);
+	if (entryTime >= exitTime || entryTime < 0.f || entryTime > 1.f)
+		return false;
+
+	toi = entryTime;
+	if (entry[0] > entry[1])
+		normal = sf::Vector2f(d[0] > 0.f ? 1.f : -1.f, 0.f);
+	else
+		normal = sf::Vector2f(0.f, d[1] > 0.f ? 1.f : -1.f);
+	return true;
+}
@@ -20,4 +20,12 @@ public:
 	// Check bounding circle collision. Returns true if collision occurs.
 	static bool checkBoundingCircle(GameObject* sp1, GameObject* sp2);
 
+	// Find the axis of least overlap between two boxes. Normal points from s1 towards s2, depth is the overlap along it.
+	// Returns false if the boxes do not overlap.
+	static bool getPenetration(const sf::FloatRect& s1, const sf::FloatRect& s2, sf::Vector2f& normal, float& depth);
+
+	// Swept AABB test, s1 moves by displacement while s2 stays still. Finds the fraction of the move (0 to 1) at which they first touch
+	// and the normal of the face hit, pointing from s1 towards s2. Returns false if they do not meet or already overlap at the start.
+	static bool sweepBoundingBox(const sf::FloatRect& s1, sf::Vector2f displacement, const sf::FloatRect& s2, float& toi, sf::Vector2f& normal);
+
 };
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "CollisionGrid.h"
+#include "CollisionLayers.h"
+#include "Collision.h"
+#include "TileMap.h"
+#include <algorithm>
+#include <cmath>
+
+CollisionGrid::CollisionGrid()
+{
+    create(sf::Vector2f(0.f, 0.f), sf::Vector2f(1.f, 1.f), 0, 0);
+}
+
+void CollisionGrid::create(sf::Vector2f gridOrigin, sf::Vector2f size, int gridWidth, int gridHeight)
+{
+    origin = gridOrigin;
+    cellSize = size;
+    width = std::max(gridWidth, 0);
+    height = std::max(gridHeight, 0);
+    cells.assign((size_t)width * height, 0);
+
+    // The matrix should be set up before the level is built, so the masks are fixed here rather than looked up per cell
+    for (int i = 0; i < 32; ++i) {
+        layerMasks[i] = CollisionLayers::getMask(1u << i);
+    }
+}
+
+void CollisionGrid::build(const TileMap& map, const std::vector<int>& emptyTiles)
+{
+    const std::vector<GameObject>& tileSet = map.getTileSet();
+    const std::vector<int>& tiles = map.getTileMap();
+    sf::Vector2u mapSize = map.getMapSize();
+    sf::Vector2f tileSize = map.getTileSize();
+    int tileCount = std::max(map.getTileCount(), (int)tileSet.size());
+    if (tileCount == 0 || mapSize.x == 0 || tileSize.x <= 0.f || tileSize.y <= 0.f) {
+        create(map.getPosition(), sf::Vector2f(1.f, 1.f), 0, 0);
+        return;
+    }
+
+    create(map.getPosition(), tileSize, (int)mapSize.x, (int)mapSize.y);
+    for (int i = 0; i < (int)tiles.size() && i < width * height; ++i) {
+        int tile = tiles[i];
+        if (tile < 0 || tile >= tileCount) continue;
+        if (std::find(emptyTiles.begin(), emptyTiles.end(), tile) != emptyTiles.end()) continue;
+        // Tiles cut from a sheet layout have no GameObject to take a layer from
+        setCell(i % width, i / width, tile < (int)tileSet.size() ? tileSet[tile].getCollisionLayer() : (std::uint32_t)CollisionLayers::Default);
+    }
+}
+
+void CollisionGrid::setCell(int x, int y, std::uint32_t layer)
+{
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+
+    std::uint8_t value = 0;
+    for (int bit = 0; bit < 32; ++bit) {
+        if (layer & (1u << bit)) {
+            value = (std::uint8_t)(bit + 1);
+            break;
+        }
+    }
+    cells[(size_t)y * width + x] = value;
+}
+
+std::uint32_t CollisionGrid::getCell(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= width || y >= height) return 0;
+    std::uint8_t value = cells[(size_t)y * width + x];
+    return value ? 1u << (value - 1) : 0;
+}
+
+sf::Vector2i CollisionGrid::getCellAt(sf::Vector2f point) const
+{
+    return sf::Vector2i((int)std::floor((point.x - origin.x) / cellSize.x), (int)std::floor((point.y - origin.y) / cellSize.y));
+}
+
+int CollisionGrid::getSolidCount() const
+{
+    return (int)(cells.size() - std::count(cells.begin(), cells.end(), (std::uint8_t)0));
+}
+
+bool CollisionGrid::blocks(int x, int y, std::uint32_t category, std::uint32_t mask) const
+{
+    if (x < 0 || y < 0 || x >= width || y >= height) return false;
+    std::uint8_t value = cells[(size_t)y * width + x];
+    if (value == 0) return false;
+    return CollisionLayers::shouldCollide(category, mask, 1u << (value - 1), layerMasks[value - 1]);
+}
+
+bool CollisionGrid::getCellRange(const sf::FloatRect& box, int& x0, int& y0, int& x1, int& y1) const
+{
+    float left = std::min(box.left, box.left + box.width);
+    float right = std::max(box.left, box.left + box.width);
+    float top = std::min(box.top, box.top + box.height);
+    float bottom = std::max(box.top, box.top + box.height);
+
+    // A box ending exactly on a cell edge only touches the next cell, so it is not included
+    x0 = std::max((int)std::floor((left - origin.x) / cellSize.x), 0);
+    y0 = std::max((int)std::floor((top - origin.y) / cellSize.y), 0);
+    x1 = std::min((int)std::ceil((right - origin.x) / cellSize.x) - 1, width - 1);
+    y1 = std::min((int)std::ceil((bottom - origin.y) / cellSize.y) - 1, height - 1);
+    return x0 <= x1 && y0 <= y1;
+}
+
+sf::FloatRect CollisionGrid::getCellRect(int x, int y) const
+{
+    return sf::FloatRect(origin.x + x * cellSize.x, origin.y + y * cellSize.y, cellSize.x, cellSize.y);
+}
+
+int CollisionGrid::collide(const sf::FloatRect& box, std::uint32_t category, std::uint32_t mask, GridContact* contacts) const
+{
+    int x0, y0, x1, y1;
+    if (!getCellRange(box, x0, y0, x1, y1)) return 0;
+
+    float left = std::min(box.left, box.left + box.width);
+    float right = std::max(box.left, box.left + box.width);
+    float top = std::min(box.top, box.top + box.height);
+    float bottom = std::max(box.top, box.top + box.height);
+
+    // Deepest contact for each direction the box can be pushed: up, down, left, right
+    const sf::Vector2f normals[4] = { sf::Vector2f(0.f, 1.f), sf::Vector2f(0.f, -1.f), sf::Vector2f(1.f, 0.f), sf::Vector2f(-1.f, 0.f) };
+    GridContact best[4];
+    for (int i = 0; i < 4; ++i) {
+        best[i].normal = normals[i];
+        best[i].depth = 0.f;
+        best[i].layer = 0;
+    }
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (!blocks(x, y, category, mask)) continue;
+            sf::FloatRect cell = getCellRect(x, y);
+
+            // The box is pushed out through the face it is least far past. If that face is against another solid cell it is a seam
+            // inside the terrain, and the neighbouring cell pushes the box out instead
+            float depths[4] = {
+                bottom - cell.top,
+                cell.top + cell.height - top,
+                right - cell.left,
+                cell.left + cell.width - left
+            };
+            const int offsets[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+            int face = 0;
+            for (int i = 1; i < 4; ++i) {
+                if (depths[i] < depths[face]) face = i;
+            }
+            if (depths[face] <= 0.f || blocks(x + offsets[face][0], y + offsets[face][1], category, mask)) continue;
+
+            if (depths[face] > best[face].depth) {
+                best[face].depth = depths[face];
+                best[face].layer = getCell(x, y);
+            }
+        }
+    }
+
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (best[i].layer != 0) {
+            contacts[count++] = best[i];
+        }
+    }
+    std::sort(contacts, contacts + count, [](const GridContact& a, const GridContact& b) { return a.depth > b.depth; });
+    return count;
+}
+
+bool CollisionGrid::sweep(const sf::FloatRect& box, sf::Vector2f displacement, std::uint32_t category, std::uint32_t mask,
+    float& toi, sf::Vector2f& normal, std::uint32_t& layer) const
+{
+    float left = std::min(box.left, box.left + displacement.x);
+    float top = std::min(box.top, box.top + displacement.y);
+    sf::FloatRect swept(left, top, std::abs(box.width) + std::abs(displacement.x), std::abs(box.height) + std::abs(displacement.y));
+
+    int x0, y0, x1, y1;
+    if (!getCellRange(swept, x0, y0, x1, y1)) return false;
+
+    bool hit = false;
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (!blocks(x, y, category, mask)) continue;
+
+            float cellToi;
+            sf::Vector2f cellNormal;
+            if (!Collision::sweepBoundingBox(box, displacement, getCellRect(x, y), cellToi, cellNormal)) continue;
+            // A face against another solid cell cannot be reached
+            if (blocks(x - (int)cellNormal.x, y - (int)cellNormal.y, category, mask)) continue;
+
+            if (!hit || cellToi < toi) {
+                hit = true;
+                toi = cellToi;
+                normal = cellNormal;
+                layer = getCell(x, y);
+            }
+        }
+    }
+    return hit;
+}
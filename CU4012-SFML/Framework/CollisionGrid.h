@@ -0,0 +1,68 @@
+// Collision Grid Class
+// Grid aligned terrain stored as one byte per cell instead of one GameObject per tile. A cell is 0 when empty, otherwise 1 + the
+// bit index of its collision layer. Boxes are only tested against the cells they overlap, so the cost does not depend on the map size.
+// Faces shared by two solid cells are inside the terrain and never push, so boxes slide along a row of cells without catching on the seams.
+// Give it to World::setCollisionGrid to have dynamic objects collide with it.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+#include <cstdint>
+
+class TileMap;
+
+class CollisionGrid
+{
+public:
+	// Contact between a box and the terrain, merged to the deepest one for each face direction
+	struct GridContact
+	{
+		sf::Vector2f normal;	// points from the box into the terrain
+		float depth;
+		std::uint32_t layer;	// layer of the cell pushed against
+	};
+	static const int maxContacts = 4;
+
+	CollisionGrid();
+
+	// Makes an empty grid of width x height cells with its top left corner at origin
+	void create(sf::Vector2f origin, sf::Vector2f cellSize, int width, int height);
+	// Makes the grid match a tile map. Tiles in emptyTiles (e.g. sky) are left empty, other tiles are solid on the collision layer
+	// of their tile in the tile set. A map cut from a sheet layout has no tile set, so build it after its buildLevel and its tiles
+	// go on the default layer
+	void build(const TileMap& map, const std::vector<int>& emptyTiles);
+
+	// Layer 0 empties the cell, otherwise the cell is solid on the lowest layer bit set. Cells outside the grid are ignored
+	void setCell(int x, int y, std::uint32_t layer);
+	// Layer of a cell, 0 if it is empty or outside the grid
+	std::uint32_t getCell(int x, int y) const;
+	sf::Vector2i getCellAt(sf::Vector2f point) const;
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	sf::Vector2f getCellSize() const { return cellSize; }
+	sf::Vector2f getOrigin() const { return origin; }
+	sf::FloatRect getBounds() const { return sf::FloatRect(origin.x, origin.y, cellSize.x * width, cellSize.y * height); }
+	int getSolidCount() const;
+
+	// Finds the contacts of a box, with the given category and mask, against the solid cells it overlaps.
+	// Fills contacts (up to maxContacts) deepest first and returns how many there are
+	int collide(const sf::FloatRect& box, std::uint32_t category, std::uint32_t mask, GridContact* contacts) const;
+	// Sweeps a box by the displacement and finds the first exposed face it hits. Returns false if it hits nothing
+	bool sweep(const sf::FloatRect& box, sf::Vector2f displacement, std::uint32_t category, std::uint32_t mask,
+		float& toi, sf::Vector2f& normal, std::uint32_t& layer) const;
+
+private:
+	// Whether the cell is solid to an object with the category and mask
+	bool blocks(int x, int y, std::uint32_t category, std::uint32_t mask) const;
+	// Range of cells the box overlaps (not just touches), clamped to the grid. Returns false if there are none
+	bool getCellRange(const sf::FloatRect& box, int& x0, int& y0, int& x1, int& y1) const;
+	sf::FloatRect getCellRect(int x, int y) const;
+
+	sf::Vector2f origin;
+	sf::Vector2f cellSize;
+	int width;
+	int height;
+	std::vector<std::uint8_t> cells;
+	std::uint32_t layerMasks[32];	// mask of each layer, taken from the layer matrix when the grid is created
+};
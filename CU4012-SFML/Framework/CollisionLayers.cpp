@@ -0,0 +1,69 @@
+#include "CollisionLayers.h"
+
+std::uint32_t CollisionLayers::matrix[32];
+bool CollisionLayers::initialised = false;
+
+// Default layer matrix, everything collides apart from the exclusions the framework has always had
+void CollisionLayers::initialise()
+{
+    initialised = true;
+    for (int i = 0; i < 32; ++i) {
+        matrix[i] = All;
+    }
+
+    // Enemies walk through each other and through collectables
+    setCollides(Enemy, Enemy, false);
+    setCollides(Enemy, Collectable, false);
+}
+
+void CollisionLayers::setCollides(std::uint32_t layerA, std::uint32_t layerB, bool collides)
+{
+    if (!initialised) initialise();
+
+    for (int i = 0; i < 32; ++i) {
+        std::uint32_t bit = 1u << i;
+        if (layerA & bit) {
+            matrix[i] = collides ? (matrix[i] | layerB) : (matrix[i] & ~layerB);
+        }
+        if (layerB & bit) {
+            matrix[i] = collides ? (matrix[i] | layerA) : (matrix[i] & ~layerA);
+        }
+    }
+}
+
+bool CollisionLayers::getCollides(std::uint32_t layerA, std::uint32_t layerB)
+{
+    return (getMask(layerA) & layerB) != 0;
+}
+
+std::uint32_t CollisionLayers::getMask(std::uint32_t category)
+{
+    if (!initialised) initialise();
+
+    // An object on several layers collides with anything one of its layers collides with
+    std::uint32_t mask = 0;
+    for (int i = 0; i < 32; ++i) {
+        if (category & (1u << i)) {
+            mask |= matrix[i];
+        }
+    }
+    return mask;
+}
+
+std::uint32_t CollisionLayers::getLayerByName(const std::string& name)
+{
+    if (name == "Player") return Player;
+    if (name == "Enemy") return Enemy;
+    if (name == "Collectable") return Collectable;
+    if (name == "Wall") return Wall;
+    return 0;
+}
+
+std::string CollisionLayers::getName(std::uint32_t layer)
+{
+    if (layer == Player) return "Player";
+    if (layer == Enemy) return "Enemy";
+    if (layer == Collectable) return "Collectable";
+    if (layer == Wall) return "Wall";
+    return "";
+}
@@ -0,0 +1,47 @@
+// Collision Layers Class
+// Every GameObject belongs to one or more collision layers (its category bits) and has a mask of the layers it collides with.
+// The world only tests a pair if each object's category is in the other's mask, a single AND each way.
+// The layer matrix below sets the default mask for each layer, so which layers collide can be configured in one place.
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+class CollisionLayers
+{
+public:
+	// Built in layers, layers up to bit 31 can be used for anything else
+	enum Layer : std::uint32_t
+	{
+		Default = 1u << 0,
+		Player = 1u << 1,
+		Enemy = 1u << 2,
+		Collectable = 1u << 3,
+		Wall = 1u << 4,
+		All = 0xFFFFFFFFu
+	};
+
+	// Set whether two layers collide, the matrix is symmetric. Objects take their mask from the matrix when their layer is set,
+	// so configure it before creating objects.
+	static void setCollides(std::uint32_t layerA, std::uint32_t layerB, bool collides);
+	static bool getCollides(std::uint32_t layerA, std::uint32_t layerB);
+
+	// Mask of every layer the given category collides with
+	static std::uint32_t getMask(std::uint32_t category);
+
+	// Layer with the same name as a tag, 0 if there is none. Used to keep string tags working with layers.
+	static std::uint32_t getLayerByName(const std::string& name);
+	// Name of a built in layer, empty for any other layer
+	static std::string getName(std::uint32_t layer);
+
+	// The per pair test done by the world
+	static bool shouldCollide(std::uint32_t categoryA, std::uint32_t maskA, std::uint32_t categoryB, std::uint32_t maskB)
+	{
+		return (categoryA & maskB) != 0 && (categoryB & maskA) != 0;
+	}
+
+private:
+	static std::uint32_t matrix[32];
+	static bool initialised;
+	static void initialise();
+};
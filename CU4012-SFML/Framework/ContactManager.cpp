@@ -0,0 +1,129 @@
+#include "ContactManager.h"
+#include <algorithm>
+
+ContactManager::ContactManager()
+{
+    stamp = 0;
+}
+
+std::uint64_t ContactManager::pairKey(int firstId, int secondId)
+{
+    if (firstId > secondId) std::swap(firstId, secondId);
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(firstId)) << 32) | static_cast<std::uint32_t>(secondId);
+}
+
+void ContactManager::beginStep()
+{
+    ++stamp;
+}
+
+void ContactManager::addContact(int firstId, int secondId, GameObject* first, GameObject* second, sf::Vector2f normal, float depth, float normalImpulse)
+{
+    std::uint64_t key = pairKey(firstId, secondId);
+    auto result = contacts.emplace(key, Contact());
+    Contact& contact = result.first->second;
+    bool isNew = result.second;
+    if (isNew) {
+        first->contactKeys.push_back(key);
+        second->contactKeys.push_back(key);
+    }
+
+    contact.first = first;
+    contact.second = second;
+    contact.normal = normal;
+    contact.depth = depth;
+    contact.normalImpulse = normalImpulse;
+    contact.stamp = stamp;
+
+    if (isNew) {
+        first->OnCollisionEnter(second, contact);
+        second->OnCollisionEnter(first, contact);
+    }
+    else {
+        first->OnCollisionStay(second, contact);
+        second->OnCollisionStay(first, contact);
+    }
+}
+
+const Contact* ContactManager::findContact(int firstId, int secondId) const
+{
+    auto it = contacts.find(pairKey(firstId, secondId));
+    return it != contacts.end() ? &it->second : nullptr;
+}
+
+void ContactManager::endStep()
+{
+    for (auto it = contacts.begin(); it != contacts.end();) {
+        // Nothing tests a sleeping object against a static or another sleeping one, so those contacts are kept as they were
+        if (it->second.stamp != stamp && !isResting(it->second)) {
+            unlink(it->second, it->first);
+            ended.push_back(*it);
+            it = contacts.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    sendExits();
+}
+
+bool ContactManager::isResting(const Contact& contact)
+{
+    bool firstMoving = !contact.first->getStatic() && !contact.first->isSleeping();
+    bool secondMoving = !contact.second->getStatic() && !contact.second->isSleeping();
+    return !firstMoving && !secondMoving;
+}
+
+void ContactManager::removeObject(GameObject* obj)
+{
+    // Swapped out first, unlinking the contacts edits the object's list
+    std::vector<std::uint64_t> keys;
+    keys.swap(obj->contactKeys);
+    for (std::uint64_t key : keys) {
+        auto it = contacts.find(key);
+        if (it == contacts.end()) continue;
+        unlink(it->second, key);
+        ended.push_back(*it);
+        contacts.erase(it);
+    }
+    sendExits();
+}
+
+void ContactManager::unlink(const Contact& contact, std::uint64_t key)
+{
+    // Objects are only in a handful of contacts, order does not matter
+    for (GameObject* obj : { contact.first, contact.second }) {
+        std::vector<std::uint64_t>& keys = obj->contactKeys;
+        auto it = std::find(keys.begin(), keys.end(), key);
+        if (it != keys.end()) {
+            *it = keys.back();
+            keys.pop_back();
+        }
+    }
+}
+
+void ContactManager::sendExits()
+{
+    // Keys are the pair of ids, lower first, so sorting them is creation order
+    std::sort(ended.begin(), ended.end(), [](const std::pair<std::uint64_t, Contact>& a, const std::pair<std::uint64_t, Contact>& b) {
+        return a.first < b.first;
+    });
+
+    // Swapped out first, the events may remove objects and end more contacts
+    std::vector<std::pair<std::uint64_t, Contact>> exits;
+    exits.swap(ended);
+    for (auto& exit : exits) {
+        const Contact& contact = exit.second;
+        contact.first->OnCollisionExit(contact.second, contact);
+        contact.second->OnCollisionExit(contact.first, contact);
+    }
+}
+
+void ContactManager::clear()
+{
+    for (auto& contact : contacts) {
+        contact.second.first->contactKeys.clear();
+        contact.second.second->contactKeys.clear();
+    }
+    contacts.clear();
+}
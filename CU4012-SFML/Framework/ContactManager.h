@@ -0,0 +1,71 @@
+// Contact Manager Class
+// Keeps the contacts between pairs of colliding objects from one step to the next, keyed by the pair of world ids.
+// New contacts fire OnCollisionEnter, contacts that carry on fire OnCollisionStay and contacts that end fire OnCollisionExit,
+// on both objects. Each contact stores its normal and depth so later steps can reuse them.
+
+#pragma once
+#include "GameObject.h"
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+struct Contact
+{
+	GameObject* first;
+	GameObject* second;
+	sf::Vector2f normal;	// points from first towards second
+	float depth;			// overlap along the normal
+	float normalImpulse;	// impulse the solver applied along the normal, reused to warm start the next step
+	int stamp;				// last step the pair was touching
+
+	// Helpers for callbacks, which can be on either object of the pair
+	GameObject* getOther(const GameObject* self) const { return self == first ? second : first; }
+	sf::Vector2f getNormal(const GameObject* self) const { return self == first ? normal : -normal; }
+};
+
+class ContactManager
+{
+public:
+	ContactManager();
+
+	// Call before reporting the contacts of a step
+	void beginStep();
+	// Reports a touching pair, firstId and secondId are the objects' world ids
+	void addContact(int firstId, int secondId, GameObject* first, GameObject* second, sf::Vector2f normal, float depth, float normalImpulse = 0.f);
+	// Contact between two objects from the last step, or nullptr
+	const Contact* findContact(int firstId, int secondId) const;
+	// Ends every contact not reported this step
+	void endStep();
+
+	// Ends every contact of an object that is leaving the world, each object keeps its own contacts so the rest are not visited
+	void removeObject(GameObject* obj);
+	// Calls the callback with each contact the object is in
+	template <typename T>
+	void forEachContact(const GameObject* obj, T&& callback) const;
+	void clear();
+
+	int getContactCount() const { return (int)contacts.size(); }
+	const std::unordered_map<std::uint64_t, Contact>& getContacts() const { return contacts; }
+
+private:
+	static std::uint64_t pairKey(int firstId, int secondId);
+	// Neither object is an awake dynamic one
+	static bool isResting(const Contact& contact);
+	// Takes the contact off both objects' lists
+	static void unlink(const Contact& contact, std::uint64_t key);
+	// Sends the exit events of the ended contacts in pair order, the map's order depends on its history
+	void sendExits();
+
+	std::unordered_map<std::uint64_t, Contact> contacts;
+	std::vector<std::pair<std::uint64_t, Contact>> ended;
+	int stamp;
+};
+
+template <typename T>
+void ContactManager::forEachContact(const GameObject* obj, T&& callback) const
+{
+	for (std::uint64_t key : obj->contactKeys) {
+		auto it = contacts.find(key);
+		if (it != contacts.end()) callback(it->second);
+	}
+}
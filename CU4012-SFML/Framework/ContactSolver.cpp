@@ -0,0 +1,122 @@
+#include "ContactSolver.h"
+#include <algorithm>
+
+// Overlap allowed to remain, so resting contacts stay touching from one step to the next
+static const float linearSlop = 0.01f;
+// Fraction of the remaining overlap removed by each position iteration
+static const float positionCorrection = 0.8f;
+// Contacts closing slower than this (pixels per second) do not bounce, stops resting objects buzzing
+static const float restitutionThreshold = 30.f;
+
+ContactSolver::ContactSolver()
+{
+    velocityIterations = 8;
+    positionIterations = 3;
+    bodyStore = nullptr;
+}
+
+void ContactSolver::setIterations(int velocity, int position)
+{
+    velocityIterations = std::max(0, velocity);
+    positionIterations = std::max(0, position);
+}
+
+void ContactSolver::clear()
+{
+    bodies.clear();
+    bodyIndex.clear();
+    contacts.clear();
+}
+
+int ContactSolver::getBody(GameObject* obj)
+{
+    auto result = bodyIndex.emplace(obj, (int)bodies.size());
+    if (result.second) {
+        Body body;
+        body.storeIndex = bodyStore ? bodyStore->indexOf(obj) : -1;
+        body.correction = sf::Vector2f(0.f, 0.f);
+        if (body.storeIndex != -1) {
+            body.velocity = bodyStore->getVelocity(body.storeIndex);
+            body.inverseMass = bodyStore->getInverseMass(body.storeIndex);
+        }
+        else {
+            body.velocity = sf::Vector2f(0.f, 0.f);
+            body.inverseMass = 0.f;
+        }
+        bodies.push_back(body);
+    }
+    return result.first->second;
+}
+
+int ContactSolver::addContact(GameObject* first, GameObject* second, sf::Vector2f normal, float depth, float warmImpulse)
+{
+    SolverContact contact;
+    contact.bodyA = getBody(first);
+    contact.bodyB = getBody(second);
+    contact.normal = normal;
+    contact.depth = depth;
+
+    float inverseMass = bodies[contact.bodyA].inverseMass + bodies[contact.bodyB].inverseMass;
+    contact.effectiveMass = inverseMass > 0.f ? 1.f / inverseMass : 0.f;
+
+    // Closing speed before solving, bounce back at the combined restitution of it
+    sf::Vector2f relative = bodies[contact.bodyB].velocity - bodies[contact.bodyA].velocity;
+    float normalVelocity = relative.x * normal.x + relative.y * normal.y;
+    float restitution = std::max(first->getRestitution(), second->getRestitution());
+    contact.velocityBias = (-normalVelocity > restitutionThreshold) ? -restitution * normalVelocity : 0.f;
+
+    contact.normalImpulse = warmImpulse;
+    contacts.push_back(contact);
+    return (int)contacts.size() - 1;
+}
+
+void ContactSolver::solve()
+{
+    // Warm start, apply last step's impulses so resting contacts begin close to the answer
+    for (auto& contact : contacts) {
+        Body& a = bodies[contact.bodyA];
+        Body& b = bodies[contact.bodyB];
+        sf::Vector2f impulse = contact.normal * contact.normalImpulse;
+        a.velocity -= impulse * a.inverseMass;
+        b.velocity += impulse * b.inverseMass;
+    }
+
+    // Velocity iterations, the accumulated impulse is clamped so contacts can push but never pull
+    for (int i = 0; i < velocityIterations; ++i) {
+        for (auto& contact : contacts) {
+            Body& a = bodies[contact.bodyA];
+            Body& b = bodies[contact.bodyB];
+            sf::Vector2f relative = b.velocity - a.velocity;
+            float normalVelocity = relative.x * contact.normal.x + relative.y * contact.normal.y;
+
+            float lambda = -(normalVelocity - contact.velocityBias) * contact.effectiveMass;
+            float newImpulse = std::max(contact.normalImpulse + lambda, 0.f);
+            lambda = newImpulse - contact.normalImpulse;
+            contact.normalImpulse = newImpulse;
+
+            sf::Vector2f impulse = contact.normal * lambda;
+            a.velocity -= impulse * a.inverseMass;
+            b.velocity += impulse * b.inverseMass;
+        }
+    }
+
+    // Position iterations, the overlap shrinks as the bodies are pushed so later iterations only remove what is left
+    for (int i = 0; i < positionIterations; ++i) {
+        for (auto& contact : contacts) {
+            Body& a = bodies[contact.bodyA];
+            Body& b = bodies[contact.bodyB];
+            sf::Vector2f moved = b.correction - a.correction;
+            float depth = contact.depth - (moved.x * contact.normal.x + moved.y * contact.normal.y);
+            float correction = std::max(depth - linearSlop, 0.f) * positionCorrection * contact.effectiveMass;
+
+            a.correction -= contact.normal * (correction * a.inverseMass);
+            b.correction += contact.normal * (correction * b.inverseMass);
+        }
+    }
+
+    for (auto& body : bodies) {
+        if (body.storeIndex == -1 || body.inverseMass == 0.f) continue;
+        bodyStore->setVelocity(body.storeIndex, body.velocity);
+        bodyStore->move(body.storeIndex, body.correction);
+    }
+}
@@ -0,0 +1,67 @@
+// Contact Solver Class
+// Sequential impulse solver for the contacts found in a step. Every contact is solved together rather than one pair at a time,
+// so resolving one pair does not undo another and stacks settle instead of jittering.
+// Each step it warm starts from the impulses of the last step, runs the velocity iterations with accumulated (clamped) impulses,
+// writes the velocities back, then runs the position iterations to push out any overlap left.
+
+#pragma once
+#include "GameObject.h"
+#include "BodyStore.h"
+#include <vector>
+#include <unordered_map>
+
+class ContactSolver
+{
+public:
+	ContactSolver();
+
+	// More iterations give stiffer, more accurate stacks for more time
+	void setIterations(int velocity, int position);
+	int getVelocityIterations() const { return velocityIterations; }
+	int getPositionIterations() const { return positionIterations; }
+
+	// Moving objects are read from and written back to the store, objects not in it are treated as immovable
+	void setBodyStore(BodyStore* store) { bodyStore = store; }
+
+	// Call at the start of each step
+	void clear();
+	// Adds a contact, the normal points from first towards second. warmImpulse is the impulse from the last step, or 0 for a new contact.
+	// Returns the contact's index
+	int addContact(GameObject* first, GameObject* second, sf::Vector2f normal, float depth, float warmImpulse);
+	// Solves every contact added since clear and updates the objects' velocities and positions
+	void solve();
+
+	// Total impulse applied along the normal of a contact this step
+	float getImpulse(int contact) const { return contacts[contact].normalImpulse; }
+	int getContactCount() const { return (int)contacts.size(); }
+
+private:
+	// Working copy of an object, written back once the iterations are done
+	struct Body
+	{
+		int storeIndex;		// -1 for immovable objects
+		sf::Vector2f velocity;
+		sf::Vector2f correction;	// position change from the position iterations
+		float inverseMass;
+	};
+
+	struct SolverContact
+	{
+		int bodyA;
+		int bodyB;
+		sf::Vector2f normal;
+		float depth;
+		float effectiveMass;		// 1 / (inverse mass A + inverse mass B)
+		float velocityBias;			// bounce target from the restitution
+		float normalImpulse;
+	};
+
+	int getBody(GameObject* obj);
+
+	int velocityIterations;
+	int positionIterations;
+	std::vector<Body> bodies;
+	std::unordered_map<GameObject*, int> bodyIndex;
+	std::vector<SolverContact> contacts;
+	BodyStore* bodyStore;
+};
@@ -1,4 +1,6 @@
 #include "GameObject.h"
+#include "BodyStore.h"
+#include "World.h"
 
 GameObject::GameObject()
 {
@@ -6,6 +8,9 @@ GameObject::GameObject()
     window = nullptr;
     alive = true;
     Colliding = false;
+    tag = Tags::None;
+    collidingTag = Tags::None;
+    setCollisionLayer(CollisionLayers::Default);
 
     collisionBoxDebug.setFillColor(sf::Color::Transparent);
     collisionBoxDebug.setOutlineColor(sf::Color::Red);
@@ -31,8 +36,23 @@ void GameObject::update(float dt)
 
 void GameObject::updateCollisionBox(float dt)
 {
-    collisionBox = sf::FloatRect(getPosition().x, getPosition().y, getSize().x, getSize().y);
-    setDebugCollisionBox(getPosition().x, getPosition().y, getSize().x, getSize().y);
+    sf::Vector2f size = customCollisionBox ? collisionSize : getSize();
+    collisionBox = sf::FloatRect(getPosition() + collisionOffset, size);
+    placeCollider(getRotation());
+    setDebugCollisionBox(collisionBox.left, collisionBox.top, collisionBox.width, collisionBox.height);
+}
+
+void GameObject::setCustomCollisionBox(sf::FloatRect box)
+{
+    // While the world is stepping the current position is in its body store
+    sf::Vector2f position = bodyStore && bodyStore->isLive() ? bodyStore->getPosition(storeIndex) : getPosition();
+    customCollisionBox = true;
+    collisionOffset = sf::Vector2f(box.left, box.top) - position;
+    collisionSize = sf::Vector2f(box.width, box.height);
+
+    collisionBox = box;
+    placeCollider(getRotation());
+    setDebugCollisionBox(collisionBox.left, collisionBox.top, collisionBox.width, collisionBox.height);
 }
 
 // Sets the velocity of the sprite
@@ -41,28 +61,36 @@ void GameObject::setVelocity(sf::Vector2f vel)
     if (!isStatic)
     {
         velocity = vel;
+        if (sleeping && (vel.x != 0.f || vel.y != 0.f))
+        {
+            wake();
+        }
+        if (bodyStore && bodyStore->isLive())
+        {
+            bodyStore->setVelocity(storeIndex, vel);
+        }
     }
 }
 void GameObject::setVelocity(float vx, float vy)
 {
-    if (!isStatic)
-    {
-        velocity.x = vx;
-        velocity.y = vy;
-    }
+    setVelocity(sf::Vector2f(vx, vy));
 }
 
 void GameObject::applyImpulse(sf::Vector2f impulse)
 {
     if (!isStatic)
     {
-        velocity += impulse / mass;
+        setVelocity(getVelocity() + impulse / mass);
     }
 }
 
 // get sprite velocity
 sf::Vector2f GameObject::getVelocity()
 {
+    if (bodyStore && bodyStore->isLive())
+    {
+        return bodyStore->getVelocity(storeIndex);
+    }
     return velocity;
 }
 
@@ -79,195 +107,126 @@ void GameObject::setDebugCollisionBox(float x, float y, float w, float h)
     collisionBoxDebug.setSize(sf::Vector2f(w, h));
 }
 
+// Checks for a collision and resolves it straight away. Returns true if the objects are colliding
 bool GameObject::checkCollision(GameObject* otherBox)
 {
-    // Skip collision detection if both objects are tiles
-    if (isTile && otherBox->getTile()) {
-        return false; // No collision detection between two tiles
+    CollisionResult result = testCollision(otherBox);
+    if (result == CollisionResult::Resolve)
+    {
+        resolveCollision(otherBox);
     }
+    return result != CollisionResult::None;
+}
 
-    if (otherBox->getTag() == "Collectable" && tag =="Enemy" || otherBox->getTag() == "Enemy" && tag == "Collectable")
-    {
-		return false;
-	}
+// Works out whether the objects collide and if the collision needs resolving. Does not change either object,
+// so the world can test pairs on several threads at once
+GameObject::CollisionResult GameObject::testCollision(const GameObject* otherBox) const
+{
+    // Skip collision detection if both objects are tiles
+    if (isTile && otherBox->isTile) {
+        return CollisionResult::None; // No collision detection between two tiles
+    }
 
-    //Check if both objects are tagged as Enemy if they are , skip collision detection
-    // This is to prevent the enemy from colliding with each other
-    if (otherBox->getTag() == "Enemy" && tag == "Enemy")
+    // Skip collision detection if the collision layers do not collide (e.g. enemies with each other or with collectables)
+    if (!CollisionLayers::shouldCollide(collisionLayer, collisionMask, otherBox->collisionLayer, otherBox->collisionMask))
     {
-		return false;
-	}
-    // Get the collision box for both objects
-    sf::FloatRect otherCollisionBox = otherBox->getCollisionBox();
+        return CollisionResult::None;
+    }
 
     // Use intersects to check if the objects are colliding
-    if (collisionBox.intersects(otherCollisionBox))
+    if (collisionBox.intersects(otherBox->collisionBox))
     {
         // Check if either object is a trigger and the other is not static
         //Doing this so that triggers can collide with non-static objects
-        if ((isTrigger && !otherBox->getStatic()) || otherBox->getTrigger() && !isStatic)
+        if ((isTrigger && !otherBox->isStatic) || otherBox->isTrigger && !isStatic)
         {
-            return true;
+            return CollisionResult::Overlap;
         }
         // Check if either object is a trigger and the other is static
-        if ((isTrigger && otherBox->getStatic()) || (otherBox->getTrigger() && isStatic))
+        // If the conditions are met, proceed with collision resolution
+        if ((isTrigger && otherBox->isStatic) || (otherBox->isTrigger && isStatic))
         {
-            // If the conditions are met, proceed with collision resolution
-            // Get the half sizes of the two objects
-            sf::Vector2f otherHalfSize = sf::Vector2f(otherCollisionBox.width / 2.0f, otherCollisionBox.height / 2.0f);
-            sf::Vector2f thisHalfSize = sf::Vector2f(collisionBox.width / 2.0f, collisionBox.height / 2.0f);
-
-            // Calculate the difference in position between the two objects
-            sf::Vector2f otherPos = otherBox->getPosition() + otherHalfSize;
-            sf::Vector2f thisPos = getPosition() + thisHalfSize;
-
-            // Calculate the intersection depth in X and Y
-            float deltaX = otherPos.x - thisPos.x;
-            float deltaY = otherPos.y - thisPos.y;
-            float intersectX = abs(deltaX) - (otherHalfSize.x + thisHalfSize.x);
-            float intersectY = abs(deltaY) - (otherHalfSize.y + thisHalfSize.y);
-
-            // Calculate the total inverse mass
-            float totalInverseMass = getInverseMass() + otherBox->getInverseMass();
-
-            // The push factor is the ratio of the other object's inverse mass to the total inverse mass
-            float push = (totalInverseMass != 0) ? otherBox->getInverseMass() / totalInverseMass : 0.0f;
-            push = std::min(std::max(push, 0.0f), 1.0f); // Clamp push value between 0 and 1
-
-            // Adjust positions to resolve collision
-            if (intersectX > intersectY) {
-                if (deltaX > 0.0f) {
-                    move(intersectX * (1.0f - push), 0.f);
-                    otherBox->move(-intersectX * push, 0.0f);
-
-                    //Collision on the right
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = 1.f;
-                        Direction.y = 0.f;
-                    }
-                }
-                else {
-                    move(-intersectX * (1.0f - push), 0.0f);
-                    otherBox->move(intersectX * push, 0.0f);
-
-                    //Collision on the left
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = -1.f;
-                        Direction.y = 0.f;
-                    }
-                }
-            }
-            else {
-                if (deltaY > 0.0f) {
-                    move(0.0f, intersectY * (1.f - push));
-                    otherBox->move(0.0f, -intersectY * push);
-
-                    //Collision on the bottom
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = 0.f;
-                        Direction.y = 1.f;
-                    }
-                    canJump = true;
-                }
-                else {
-                    move(0.0f, -intersectY * (1.0f - push));
-                    otherBox->move(0.0f, intersectY * push);
-
-                    //Collision on the top
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = 0.f;
-                        Direction.y = -1.f;
-                    }
-                }
-            }
-
-            return true;
+            return CollisionResult::Resolve;
         }
-        else if (!isTrigger && !otherBox->getTrigger())
+        // If neither object is a trigger, proceed with collision resolution
+        else if (!isTrigger && !otherBox->isTrigger)
         {
-            // If neither object is a trigger, proceed with collision resolution
-            // Get the half sizes of the two objects
-            sf::Vector2f otherHalfSize = sf::Vector2f(otherCollisionBox.width / 2.0f, otherCollisionBox.height / 2.0f);
-            sf::Vector2f thisHalfSize = sf::Vector2f(collisionBox.width / 2.0f, collisionBox.height / 2.0f);
-
-            // Calculate the difference in position between the two objects
-            sf::Vector2f otherPos = otherBox->getPosition() + otherHalfSize;
-            sf::Vector2f thisPos = getPosition() + thisHalfSize;
-
-            // Calculate the intersection depth in X and Y
-            float deltaX = otherPos.x - thisPos.x;
-            float deltaY = otherPos.y - thisPos.y;
-            float intersectX = abs(deltaX) - (otherHalfSize.x + thisHalfSize.x);
-            float intersectY = abs(deltaY) - (otherHalfSize.y + thisHalfSize.y);
-
-            // Calculate the total inverse mass
-            float totalInverseMass = getInverseMass() + otherBox->getInverseMass();
-
-            // The push factor is the ratio of the other object's inverse mass to the total inverse mass
-            float push = (totalInverseMass != 0) ? otherBox->getInverseMass() / totalInverseMass : 0.0f;
-            push = std::min(std::max(push, 0.0f), 1.0f); // Clamp push value between 0 and 1
-
-            // Adjust positions to resolve collision
-            if (intersectX > intersectY) {
-                if (deltaX > 0.0f) {
-                    move(intersectX * (1.0f - push), 0.f);
-                    otherBox->move(-intersectX * push, 0.0f);
-
-                    //Collision on the right
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = 1.f;
-                        Direction.y = 0.f;
-                    }
-                }
-                else {
-                    move(-intersectX * (1.0f - push), 0.0f);
-                    otherBox->move(intersectX * push, 0.0f);
-
-                    //Collision on the left
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = -1.f;
-                        Direction.y = 0.f;
-                    }
-                }
-            }
-            else {
-                if (deltaY > 0.0f) {
-                    move(0.0f, intersectY * (1.f - push));
-                    otherBox->move(0.0f, -intersectY * push);
-
-                    //Collision on the bottom
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = 0.f;
-                        Direction.y = 1.f;
-                    }
-                    canJump = true;
-                }
-                else {
-                    move(0.0f, -intersectY * (1.0f - push));
-                    otherBox->move(0.0f, intersectY * push);
-
-                    //Collision on the top
-                    if (!otherBox->getStatic())
-                    {
-                        Direction.x = 0.f;
-                        Direction.y = -1.f;
-                    }
-                }
-            }
-            return true;
+            return CollisionResult::Resolve;
         }
         // If none of the conditions are met, it means either both are triggers
         // or the collision shouldn't be resolved (e.g., two non-static objects)
-        return false;
+        return CollisionResult::None;
+    }
+    return CollisionResult::None;
+}
+
+// Pushes the objects apart along the axis of least overlap, shared out by their inverse masses
+void GameObject::resolveCollision(GameObject* otherBox)
+{
+    // Get the collision box for both objects
+    sf::FloatRect otherCollisionBox = otherBox->getCollisionBox();
+
+    // Get the half sizes of the two objects
+    sf::Vector2f otherHalfSize = sf::Vector2f(otherCollisionBox.width / 2.0f, otherCollisionBox.height / 2.0f);
+    sf::Vector2f thisHalfSize = sf::Vector2f(collisionBox.width / 2.0f, collisionBox.height / 2.0f);
+
+    // Calculate the difference in position between the two objects
+    sf::Vector2f otherPos = otherBox->getPosition() + otherHalfSize;
+    sf::Vector2f thisPos = getPosition() + thisHalfSize;
+
+    // Calculate the intersection depth in X and Y
+    float deltaX = otherPos.x - thisPos.x;
+    float deltaY = otherPos.y - thisPos.y;
+    float intersectX = abs(deltaX) - (otherHalfSize.x + thisHalfSize.x);
+    float intersectY = abs(deltaY) - (otherHalfSize.y + thisHalfSize.y);
+
+    // Calculate the total inverse mass
+    float totalInverseMass = getInverseMass() + otherBox->getInverseMass();
+
+    // The push factor is the ratio of the other object's inverse mass to the total inverse mass
+    float push = (totalInverseMass != 0) ? otherBox->getInverseMass() / totalInverseMass : 0.0f;
+    push = std::min(std::max(push, 0.0f), 1.0f); // Clamp push value between 0 and 1
+
+    // Adjust positions to resolve collision
+    if (intersectX > intersectY) {
+        if (deltaX > 0.0f) {
+            move(intersectX * (1.0f - push), 0.f);
+            otherBox->move(-intersectX * push, 0.0f);
+            setContactNormal(otherBox, sf::Vector2f(1.f, 0.f)); //Collision on the right
+        }
+        else {
+            move(-intersectX * (1.0f - push), 0.0f);
+            otherBox->move(intersectX * push, 0.0f);
+            setContactNormal(otherBox, sf::Vector2f(-1.f, 0.f)); //Collision on the left
+        }
+    }
+    else {
+        if (deltaY > 0.0f) {
+            move(0.0f, intersectY * (1.f - push));
+            otherBox->move(0.0f, -intersectY * push);
+            setContactNormal(otherBox, sf::Vector2f(0.f, 1.f)); //Collision on the bottom
+        }
+        else {
+            move(0.0f, -intersectY * (1.0f - push));
+            otherBox->move(0.0f, intersectY * push);
+            setContactNormal(otherBox, sf::Vector2f(0.f, -1.f)); //Collision on the top
+        }
+    }
+}
+
+// Records the side that was hit, normal points from this object towards the other
+void GameObject::setContactNormal(GameObject* otherBox, sf::Vector2f normal)
+{
+    // Direction only tracks hits from other moving objects
+    if (!otherBox->getStatic())
+    {
+        Direction = normal;
+    }
+    // Standing on something, allow jumping
+    if (normal.y > 0.f)
+    {
+        canJump = true;
     }
-    return false;
 }
 
 
@@ -296,20 +255,49 @@ bool GameObject::checkCollision(GameObject* otherBox)
 //}
 void GameObject::collisionResponse(GameObject* collider)
 {
-    // Check if collider is a tile and has a specific tag ("Wall" or "Collectable"), or if it is neither static nor a tile.
-    if ((collider->getTile() && (collider->getTag() == "Wall" || collider->getTag() == "Collectable")) ||
+    // Check if collider is a tile on the Wall or Collectable layer, or if it is neither static nor a tile.
+    if ((collider->getTile() && (collider->collisionLayer & (CollisionLayers::Wall | CollisionLayers::Collectable))) ||
         (!collider->getStatic() && !collider->getTile()))
     {
         // Update the colliding tag
-        collidingTag = collider->getTag();
+        collidingTag = collider->tag;
+    }
+}
+void GameObject::setTag(const std::string& t)
+{
+    // The layer only follows the tag while nothing else has set it, and the mask only while it is the layer matrix's
+    std::uint32_t tagLayer = CollisionLayers::getLayerByName(Tags::getName(tag));
+    bool layerFromTag = collisionLayer == CollisionLayers::Default || (tagLayer != 0 && collisionLayer == tagLayer);
+    bool maskFromLayer = collisionMask == CollisionLayers::getMask(collisionLayer);
+
+    tag = Tags::getId(t);
+
+    // Tags that match a layer name put the object on that layer, so tagged objects keep their collision rules
+    if (layerFromTag)
+    {
+        std::uint32_t layer = CollisionLayers::getLayerByName(t);
+        collisionLayer = layer != 0 ? layer : (std::uint32_t)CollisionLayers::Default;
+        if (maskFromLayer)
+        {
+            collisionMask = CollisionLayers::getMask(collisionLayer);
+        }
     }
 }
+
 void GameObject::Jump(float jumpHeight)
 {
-    velocity.y = -sqrt(2.0f * 981.0f * jumpHeight);
+    setVelocity(getVelocity().x, -sqrt(2.0f * 981.0f * jumpHeight));
     canJump = false;
 }
 
+void GameObject::wake()
+{
+    if (sleeping && world)
+    {
+        world->wakeObject(*this);
+    }
+}
+
 std::string GameObject::getCollisionDirection()
 {
     //If the direction is not 0,0
@@ -351,7 +339,11 @@ void GameObject::UpdatePhysics(sf::Vector2f* gravity, float deltaTime)
             velocity.y += gravity->y * deltaTime;
 
             // Clamp the gravity so that the object does not fall through the floor also known as tunneling
-            velocity.y = std::min(velocity.y, gravity->y);
+            // Bullets are swept by the world instead, so they can fall as fast as they like
+            if (!isBullet)
+            {
+                velocity.y = std::min(velocity.y, gravity->y);
+            }
         }
         angularVelocity += torque * deltaTime;
         setRotation(getRotation() + angularVelocity * deltaTime);
@@ -359,3 +351,20 @@ void GameObject::UpdatePhysics(sf::Vector2f* gravity, float deltaTime)
         updateCollisionBox(deltaTime);
     }
 }
+
+sf::Vector2f GameObject::getInterpolatedPosition(float alpha)
+{
+    // Static objects are not stepped, so their previous position is not kept up to date
+    if (isStatic)
+    {
+        return getPosition();
+    }
+    return previousPosition + (getPosition() - previousPosition) * alpha;
+}
+
+sf::Transform GameObject::getInterpolationTransform(float alpha)
+{
+    sf::Transform transform;
+    transform.translate(getInterpolatedPosition(alpha) - getPosition());
+    return transform;
+}
@@ -9,6 +9,17 @@
 #include "SFML\Graphics.hpp"
 #include "Input.h"
 #include "AudioManager.h"
+#include "CollisionLayers.h"
+#include "Tags.h"
+#include "SlotMap.h"
+#include "Collider.h"
+
+struct Contact;
+class BodyStore;
+class World;
+
+// Handle to an object in a World, goes stale when the object is removed. See World::getObject
+using BodyHandle = SlotHandle;
 
 class GameObject : public sf::RectangleShape
 {
@@ -20,7 +31,7 @@ public:
 	virtual void handleInput(float dt);
 	virtual void update(float dt);
 
-	// Control sprite speed and direction
+	// Control sprite speed and direction. While the world is stepping these go to its body store
 	void setVelocity(sf::Vector2f vel);
 	void setVelocity(float vx, float vy);
 	void applyImpulse(sf::Vector2f impulse);
@@ -39,8 +50,18 @@ public:
 
 	sf::RectangleShape getDebugCollisionBox() { return collisionBoxDebug; }
 
-	std::string getTag() { return tag; }
-	bool CollisionWithTag(const std::string& otherTag) { return collidingTag == otherTag; }
+	// Shape tested against other objects once their collision boxes overlap, a Box by default. Other shapes sit on the centre of the
+	// collision box and turn with the object's rotation, the collision box then grows to fit them
+	void setCollider(const Collider& c) { collider = c; placeCollider(getRotation()); }
+	const Collider& getCollider() const { return collider; }
+	PlacedCollider getPlacedCollider() const { return { &collider, colliderTransform, collisionBox }; }
+
+	const std::string& getTag() const { return Tags::getName(tag); }
+	int getTagId() const { return tag; }
+	// Prefer the id version in code that runs every frame, look the id up once with Tags::getId
+	bool CollisionWithTag(int otherTag) const { return collidingTag == otherTag; }
+	bool CollisionWithTag(const std::string& otherTag) const { return collidingTag == Tags::findId(otherTag); }
+	int getCollidingTagId() const { return collidingTag; }
 
 	// Set the input component
 	void setInput(Input* in) { input = in; };
@@ -50,12 +71,30 @@ public:
 	std::string getCollisionDirection();
 
 
+	// Result of testing a pair, Overlap means they touch but are not pushed apart (triggers)
+	enum class CollisionResult { None, Overlap, Resolve };
+
 	//Called Every Frame in world class 
 	bool checkCollision(GameObject* other);
+	// Detection only, safe to call from several threads at once
+	CollisionResult testCollision(const GameObject* other) const;
+	// Moves the objects apart, must be called from one thread in a fixed order
+	void resolveCollision(GameObject* other);
 	void collisionResponse(GameObject* collider);
-	void clearCollision() { collidingTag = ""; }
+
+	// Contact events sent by the world. Enter is called once when a contact begins, Stay every step it carries on and Exit when it ends.
+	// Objects must not be added to or removed from the world inside these.
+	virtual void OnCollisionEnter(GameObject* /*other*/, const Contact& /*contact*/) {}
+	virtual void OnCollisionStay(GameObject* /*other*/, const Contact& /*contact*/) {}
+	virtual void OnCollisionExit(GameObject* /*other*/, const Contact& /*contact*/) {}
+	void clearCollision() { collidingTag = Tags::None; }
 	void UpdatePhysics(sf::Vector2f* gravity, float deltaTime);
 
+	// Position blended between the last two physics steps, alpha comes from World::getAlpha.
+	// Draw with the transform so movement stays smooth when the frame rate and the physics step rate differ
+	sf::Vector2f getInterpolatedPosition(float alpha);
+	sf::Transform getInterpolationTransform(float alpha);
+
 	//Collision Types 
 	void setTrigger(bool t) { isTrigger = t; }
 	bool getTrigger() { return isTrigger; }
@@ -66,6 +105,20 @@ public:
 	void setStatic(bool s) { isStatic = s; }
 	bool getStatic() { return isStatic; }
 
+	// Sleeping objects have come to rest and are skipped by the world until something wakes them: an awake object touching them,
+	// a non zero setVelocity or applyImpulse, or wake. Call wake after moving a sleeping object with setPosition
+	bool isSleeping() const { return sleeping; }
+	void wake();
+
+	// Bullets are swept along their whole move each step so they cannot pass through thin objects when moving fast.
+	// Their fall speed is not clamped to the gravity either, the sweep is what stops them tunnelling
+	void setBullet(bool b) { isBullet = b; }
+	bool getBullet() const { return isBullet; }
+
+	// Bounciness used by the world's contact solver, 0 stops dead and 1 bounces back at full speed. A pair uses the larger of the two
+	void setRestitution(float r) { restitution = r; }
+	float getRestitution() const { return restitution; }
+
 	void setMassless(bool m) { isMassless = m; }
 	bool getMassless() { return isMassless; }
 	float getMass() const
@@ -80,33 +133,33 @@ public:
 		return isStatic ? 0.0f : inverseMass;
 	}
 	void setColor(sf::Color c) { collisionBoxDebug.setOutlineColor(c); }
-	void setTag(const std::string& t) { tag = t; }
+	// Setting a tag that names a built in collision layer (e.g. "Enemy") also puts the object on that layer, as long as its layer
+	// is still the default or the one its old tag gave it. A layer or mask set on purpose is kept
+	void setTag(const std::string& t);
+
+	// Collision layers, the layer is the object's category bits, the mask is the layers it collides with.
+	// Setting the layer resets the mask from the layer matrix in CollisionLayers.
+	void setCollisionLayer(std::uint32_t layer) { collisionLayer = layer; collisionMask = CollisionLayers::getMask(layer); }
+	void setCollisionMask(std::uint32_t mask) { collisionMask = mask; }
+	std::uint32_t getCollisionLayer() const { return collisionLayer; }
+	std::uint32_t getCollisionMask() const { return collisionMask; }
 
 
+	// Handle given out by World::AddGameObject, stale while the object is not in a world
+	BodyHandle getWorldHandle() const { return worldHandle; }
+
 	void setTextureName(const std::string& name) { textureName = name; }
 	std::string getTextureName() const { return textureName; }
 
 protected:
-	// Collision functions
-	void setCollisionBox(float x, float y, float width, float height)
-	{
-		collisionBox = sf::FloatRect(x, y, width, height);
-		setDebugCollisionBox(x, y, width, height);
-	};
-	void setCollisionBox(sf::Vector2f pos, sf::Vector2f size)
-	{
-		collisionBox = sf::FloatRect(pos.x, pos.y, size.x, size.y);
-		setDebugCollisionBox(pos.x, pos.y, size.x, size.y);
-
-	}
-	void setCollisionBox(sf::FloatRect fr)
-	{
-		collisionBox = fr;
-		setDebugCollisionBox(fr.left, fr.top, fr.width, fr.height);
-	};
+	// Collision functions. The box keeps its offset from the position and its size, so it moves with the object
+	// (through the physics steps too) until it is set again
+	void setCollisionBox(float x, float y, float width, float height) { setCustomCollisionBox(sf::FloatRect(x, y, width, height)); };
+	void setCollisionBox(sf::Vector2f pos, sf::Vector2f size) { setCustomCollisionBox(sf::FloatRect(pos, size)); }
+	void setCollisionBox(sf::FloatRect fr) { setCustomCollisionBox(fr); };
 
 	void updateCollisionBox(float dt);
-	float restitution = 1;
+	float restitution = 0;
 
 	void setMass(float m)
 	{
@@ -150,10 +203,49 @@ protected:
 	AudioManager* audio;
 	sf::RenderWindow* window;
 private:
+	// The world keeps its own bookkeeping on each object
+	friend class World;
+	friend class BodyStore;
+	friend class ContactManager;
+	int worldId = -1;	// creation order in the world, keeps collision resolution order stable
+	int proxyId = -1;	// sweep and prune proxy, only while it is the broadphase in use
+	int treeProxyId = -1;	// AABB tree proxy, every object in the world has one
+	sf::Vector2f previousPosition;	// position before the last physics step, for render interpolation
+	BodyHandle worldHandle;	// slot in the world's object map
+	int bodyIndex = -1;	// index in the world's dynamic or static list, for constant time removal
+	bool removalQueued = false;	// removed during a step, taken out of the world at the end of it
+	BodyStore* bodyStore = nullptr;	// store holding the physics state of a moving object in a world
+	World* world = nullptr;	// world the object is in, to wake it
+	bool sleeping = false;
+	GameObject* nextInIsland = nullptr;	// sleeping objects are linked in a ring with the rest of their island, to wake them together
+	int storeIndex = -1;
+	std::vector<std::uint64_t> contactKeys;	// contacts the object is in, so leaving the world only visits its own
+
 	bool isStatic;
 	bool isTrigger;
 	bool isTile;
 	bool isMassless;
+	bool isBullet = false;
+
+	// Box set with setCollisionBox, relative to the position. Without one the box is the object's size at its position
+	bool customCollisionBox = false;
+	sf::Vector2f collisionOffset;
+	sf::Vector2f collisionSize;
+	void setCustomCollisionBox(sf::FloatRect box);
+
+	// Puts the collider on the centre of the collision box, a shape other than Box also resizes the box to its bounds
+	void placeCollider(float rotation)
+	{
+		colliderTransform.position = sf::Vector2f(collisionBox.left + collisionBox.width / 2.f, collisionBox.top + collisionBox.height / 2.f);
+		if (collider.type != Collider::Type::Box)
+		{
+			colliderTransform = ColliderTransform(colliderTransform.position, rotation);
+			collisionBox = collider.getBounds(colliderTransform);
+		}
+	}
+
+	// Sets the collision direction and canJump from a contact normal pointing at the other object
+	void setContactNormal(GameObject* other, sf::Vector2f normal);
 
 
 	//Movement variables
@@ -163,8 +255,8 @@ private:
 	sf::Vector2f force;
 	sf::Vector2f acceleration;
 
-	float angularVelocity;
-	float torque;
+	float angularVelocity = 0;
+	float torque = 0;
 	float mass = 1;
 	float inverseMass = 1;
 	float inertia = 500.f;
@@ -173,11 +265,17 @@ private:
 	// Collision vars
 	sf::FloatRect collisionBox;
 	sf::RectangleShape collisionBoxDebug;
+	Collider collider;
+	ColliderTransform colliderTransform;
 	bool Colliding;
 
 	//Textures
 	std::string textureName;
 
-	std::string tag;
-	std::string collidingTag;
+	// Interned tag ids, see Tags
+	int tag;
+	int collidingTag;
+
+	std::uint32_t collisionLayer;
+	std::uint32_t collisionMask;
 };
\ No newline at end of file
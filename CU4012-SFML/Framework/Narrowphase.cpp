@@ -0,0 +1,245 @@
+#include "Narrowphase.h"
+#include "Collision.h"
+#include <algorithm>
+#include <limits>
+
+// A collider in world space as a convex core of up to 8 points and a radius around it.
+// Circles are a point, capsules a line, boxes and polygons have no radius
+struct Core
+{
+    int count;
+    int edgeCount;      // a line has one edge, a point none
+    int normalCount;    // a line has a normal for each side
+    float radius;
+    sf::Vector2f points[Collider::maxVertices];
+    sf::Vector2f normals[Collider::maxVertices];
+};
+
+static float dot(sf::Vector2f a, sf::Vector2f b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+static void makeCore(const PlacedCollider& placed, Core& core)
+{
+    const Collider& collider = *placed.collider;
+    const ColliderTransform& transform = placed.transform;
+
+    if (collider.type == Collider::Type::Box) {
+        const sf::FloatRect& box = placed.box;
+        core.count = 4;
+        core.edgeCount = 4;
+        core.normalCount = 4;
+        core.radius = 0.f;
+        core.points[0] = sf::Vector2f(box.left, box.top);
+        core.points[1] = sf::Vector2f(box.left + box.width, box.top);
+        core.points[2] = sf::Vector2f(box.left + box.width, box.top + box.height);
+        core.points[3] = sf::Vector2f(box.left, box.top + box.height);
+        core.normals[0] = sf::Vector2f(0.f, -1.f);
+        core.normals[1] = sf::Vector2f(1.f, 0.f);
+        core.normals[2] = sf::Vector2f(0.f, 1.f);
+        core.normals[3] = sf::Vector2f(-1.f, 0.f);
+        return;
+    }
+
+    core.count = collider.vertexCount;
+    core.edgeCount = core.count >= 3 ? core.count : core.count - 1;
+    core.normalCount = core.count >= 2 ? core.count : 0;
+    core.radius = collider.radius;
+    for (int i = 0; i < core.count; ++i) {
+        core.points[i] = transform.apply(collider.vertices[i]);
+    }
+    for (int i = 0; i < core.normalCount; ++i) {
+        core.normals[i] = transform.rotate(collider.normals[i]);
+    }
+}
+
+// Largest separation of b from a along a's edge normals, the axis is returned in axis
+static float findMaxSeparation(const Core& a, const Core& b, sf::Vector2f& axis)
+{
+    float best = -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < a.normalCount; ++i) {
+        float separation = std::numeric_limits<float>::infinity();
+        for (int j = 0; j < b.count; ++j) {
+            separation = std::min(separation, dot(a.normals[i], b.points[j] - a.points[i]));
+        }
+        if (separation > best) {
+            best = separation;
+            axis = a.normals[i];
+        }
+    }
+    return best;
+}
+
+// Closest points between the two cores when they do not overlap, from each point of one to each edge of the other
+static float closestFeatures(const Core& a, const Core& b, sf::Vector2f& pointA, sf::Vector2f& pointB)
+{
+    float best = std::numeric_limits<float>::infinity();
+    auto consider = [&best, &pointA, &pointB](sf::Vector2f onA, sf::Vector2f onB) {
+        sf::Vector2f delta = onB - onA;
+        float distanceSquared = dot(delta, delta);
+        if (distanceSquared < best) {
+            best = distanceSquared;
+            pointA = onA;
+            pointB = onB;
+        }
+    };
+
+    for (int i = 0; i < a.count; ++i) {
+        for (int j = 0; j < b.edgeCount; ++j) {
+            consider(a.points[i], Narrowphase::closestOnSegment(a.points[i], b.points[j], b.points[(j + 1) % b.count]));
+        }
+        if (b.edgeCount == 0) {
+            consider(a.points[i], b.points[0]);
+        }
+    }
+    for (int j = 0; j < b.count; ++j) {
+        for (int i = 0; i < a.edgeCount; ++i) {
+            consider(Narrowphase::closestOnSegment(b.points[j], a.points[i], a.points[(i + 1) % a.count]), b.points[j]);
+        }
+    }
+    return std::sqrt(best);
+}
+
+// Separating axes on the cores, valid as long as one of them is a polygon so every axis needed is tested, or both are crossing lines.
+// Overlapping cores are pushed apart along the axis of least overlap, otherwise the radii meet between the closest features
+static bool collideCores(const Core& a, const Core& b, sf::Vector2f& normal, float& depth)
+{
+    sf::Vector2f axisA, axisB;
+    float separationA = findMaxSeparation(a, b, axisA);
+    float separationB = findMaxSeparation(b, a, axisB);
+    float radius = a.radius + b.radius;
+
+    float separation = separationA;
+    sf::Vector2f axis = axisA;
+    if (separationB > separationA) {
+        separation = separationB;
+        axis = -axisB;
+    }
+    if (separation > radius) return false;
+
+    if (separation <= 0.f) {
+        normal = axis;
+        depth = radius - separation;
+        return true;
+    }
+
+    // Cores apart but close enough for the rounded edges to touch
+    if (radius <= 0.f) return false;
+    sf::Vector2f pointA, pointB;
+    float distance = closestFeatures(a, b, pointA, pointB);
+    if (distance >= radius) return false;
+    normal = distance > 0.f ? (pointB - pointA) / distance : axis;
+    depth = radius - distance;
+    return true;
+}
+
+static bool genericPair(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    Core coreA, coreB;
+    makeCore(a, coreA);
+    makeCore(b, coreB);
+    return collideCores(coreA, coreB, normal, depth);
+}
+
+static bool boxBoxPair(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    return Collision::getPenetration(a.box, b.box, normal, depth);
+}
+
+static bool circleBoxPair(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    return Narrowphase::circleBox(a.transform.position, a.collider->radius, b.box, normal, depth);
+}
+
+static bool circleCirclePair(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    return Narrowphase::circleCircle(a.transform.position, a.collider->radius, b.transform.position, b.collider->radius, normal, depth);
+}
+
+static bool circleCapsulePair(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    const Collider& capsule = *b.collider;
+    return Narrowphase::circleSegment(a.transform.position, a.collider->radius,
+        b.transform.apply(capsule.vertices[0]), b.transform.apply(capsule.vertices[1]), capsule.radius, normal, depth);
+}
+
+static bool capsuleCapsulePair(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    sf::Vector2f closestA, closestB;
+    Narrowphase::closestBetweenSegments(a.transform.apply(a.collider->vertices[0]), a.transform.apply(a.collider->vertices[1]),
+        b.transform.apply(b.collider->vertices[0]), b.transform.apply(b.collider->vertices[1]), closestA, closestB);
+    // Crossing lines have no direction between their closest points, separating axes find the way out instead
+    sf::Vector2f delta = closestB - closestA;
+    if (dot(delta, delta) < 0.0001f) {
+        return genericPair(a, b, normal, depth);
+    }
+    return Narrowphase::circleCircle(closestA, a.collider->radius, closestB, b.collider->radius, normal, depth);
+}
+
+// Runs a routine written for the pair the other way round and turns the normal back
+template <Narrowphase::Routine routine>
+static bool swapped(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+{
+    if (!routine(b, a, normal, depth)) return false;
+    normal = -normal;
+    return true;
+}
+
+// Rows are the first collider's type, columns the second's, in the order of Collider::Type
+Narrowphase::Routine Narrowphase::table[(int)Collider::Type::Count][(int)Collider::Type::Count] = {
+    // Box
+    { boxBoxPair, swapped<circleBoxPair>, genericPair, genericPair, genericPair },
+    // Circle
+    { circleBoxPair, circleCirclePair, circleCapsulePair, genericPair, genericPair },
+    // Capsule
+    { genericPair, swapped<circleCapsulePair>, capsuleCapsulePair, genericPair, genericPair },
+    // Oriented box
+    { genericPair, genericPair, genericPair, genericPair, genericPair },
+    // Polygon
+    { genericPair, genericPair, genericPair, genericPair, genericPair }
+};
+
+void Narrowphase::closestBetweenSegments(sf::Vector2f p1, sf::Vector2f q1, sf::Vector2f p2, sf::Vector2f q2, sf::Vector2f& c1, sf::Vector2f& c2)
+{
+    sf::Vector2f d1 = q1 - p1;
+    sf::Vector2f d2 = q2 - p2;
+    sf::Vector2f r = p1 - p2;
+    float a = dot(d1, d1);
+    float e = dot(d2, d2);
+    float f = dot(d2, r);
+    float s = 0.f;
+    float t = 0.f;
+
+    if (a <= 0.f && e <= 0.f) {
+        c1 = p1;
+        c2 = p2;
+        return;
+    }
+    if (a <= 0.f) {
+        t = std::min(std::max(f / e, 0.f), 1.f);
+    }
+    else {
+        float c = dot(d1, r);
+        if (e <= 0.f) {
+            s = std::min(std::max(-c / a, 0.f), 1.f);
+        }
+        else {
+            // Closest points of the infinite lines, clamped to the first segment then fitted to the second
+            float b = dot(d1, d2);
+            float denominator = a * e - b * b;
+            s = denominator != 0.f ? std::min(std::max((b * f - c * e) / denominator, 0.f), 1.f) : 0.f;
+            t = (b * s + f) / e;
+            if (t < 0.f) {
+                t = 0.f;
+                s = std::min(std::max(-c / a, 0.f), 1.f);
+            }
+            else if (t > 1.f) {
+                t = 1.f;
+                s = std::min(std::max((b - c) / a, 0.f), 1.f);
+            }
+        }
+    }
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+}
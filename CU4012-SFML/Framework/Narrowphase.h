@@ -0,0 +1,80 @@
+// Narrowphase Class
+// Exact collision tests between pairs of colliders, run by the world on the pairs whose collision boxes overlap.
+// Each pair of collider types has an entry in a dispatch table holding the cheapest routine for it: boxes use the plain AABB test,
+// circles and capsules use closest point tests, and anything with an oriented box or polygon uses separating axes on the shapes' cores
+// with the closest features between the cores for the rounded part. The small routines are inline below so hot loops can use them directly.
+// Every test works on the stack and never allocates. The normal points from the first collider towards the second.
+
+#pragma once
+#include "Collider.h"
+#include <cmath>
+
+class Narrowphase
+{
+public:
+	using Routine = bool (*)(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth);
+
+	// Tests two placed colliders with the routine for their types. Returns false if they do not touch
+	static bool collide(const PlacedCollider& a, const PlacedCollider& b, sf::Vector2f& normal, float& depth)
+	{
+		return table[(int)a.collider->type][(int)b.collider->type](a, b, normal, depth);
+	}
+	static Routine getRoutine(Collider::Type a, Collider::Type b) { return table[(int)a][(int)b]; }
+
+	static bool circleCircle(sf::Vector2f a, float radiusA, sf::Vector2f b, float radiusB, sf::Vector2f& normal, float& depth)
+	{
+		sf::Vector2f delta = b - a;
+		float radius = radiusA + radiusB;
+		float distanceSquared = delta.x * delta.x + delta.y * delta.y;
+		if (distanceSquared >= radius * radius) return false;
+
+		// Circles on top of each other have no direction between them, push them apart vertically
+		float distance = std::sqrt(distanceSquared);
+		normal = distance > 0.f ? delta / distance : sf::Vector2f(0.f, 1.f);
+		depth = radius - distance;
+		return true;
+	}
+
+	static bool circleBox(sf::Vector2f centre, float radius, const sf::FloatRect& box, sf::Vector2f& normal, float& depth)
+	{
+		float right = box.left + box.width;
+		float bottom = box.top + box.height;
+		sf::Vector2f closest(std::fmin(std::fmax(centre.x, box.left), right), std::fmin(std::fmax(centre.y, box.top), bottom));
+		if (closest != centre) {
+			return circleCircle(centre, radius, closest, 0.f, normal, depth);
+		}
+
+		// Centre inside the box, push the circle out through the nearest side
+		float sides[4] = { centre.x - box.left, right - centre.x, centre.y - box.top, bottom - centre.y };
+		const sf::Vector2f normals[4] = { sf::Vector2f(1.f, 0.f), sf::Vector2f(-1.f, 0.f), sf::Vector2f(0.f, 1.f), sf::Vector2f(0.f, -1.f) };
+		int nearest = 0;
+		for (int i = 1; i < 4; ++i) {
+			if (sides[i] < sides[nearest]) nearest = i;
+		}
+		normal = normals[nearest];
+		depth = radius + sides[nearest];
+		return true;
+	}
+
+	static sf::Vector2f closestOnSegment(sf::Vector2f p, sf::Vector2f a, sf::Vector2f b)
+	{
+		sf::Vector2f ab = b - a;
+		float lengthSquared = ab.x * ab.x + ab.y * ab.y;
+		if (lengthSquared <= 0.f) return a;
+		float t = ((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / lengthSquared;
+		t = std::fmin(std::fmax(t, 0.f), 1.f);
+		return a + ab * t;
+	}
+
+	// Circle against a line with rounded ends, the core of a capsule
+	static bool circleSegment(sf::Vector2f centre, float radius, sf::Vector2f a, sf::Vector2f b, float segmentRadius, sf::Vector2f& normal, float& depth)
+	{
+		return circleCircle(centre, radius, closestOnSegment(centre, a, b), segmentRadius, normal, depth);
+	}
+
+	// Closest points between the lines p1-q1 and p2-q2
+	static void closestBetweenSegments(sf::Vector2f p1, sf::Vector2f q1, sf::Vector2f p2, sf::Vector2f q2, sf::Vector2f& c1, sf::Vector2f& c2);
+
+private:
+	static Routine table[(int)Collider::Type::Count][(int)Collider::Type::Count];
+};
@@ -0,0 +1,108 @@
+// Slot Map Class
+// Stores values contiguously and hands out handles to them. Inserting and removing are O(1): a removed value is swapped with
+// the last one so the storage never has gaps, and the handle's slot is recycled with a new generation.
+// A handle to a removed value can always be detected, even after its slot has been reused, because the generations no longer match.
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+// Handle to a value in a slot map, the default handle is never valid
+struct SlotHandle
+{
+	std::uint32_t index = 0xFFFFFFFF;
+	std::uint32_t generation = 0;
+
+	bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+template <typename T>
+class SlotMap
+{
+public:
+	SlotHandle insert(const T& value)
+	{
+		std::uint32_t slot;
+		if (freeList != none) {
+			slot = freeList;
+			freeList = slots[slot].dense;
+		}
+		else {
+			slot = (std::uint32_t)slots.size();
+			slots.push_back(Slot());
+		}
+
+		slots[slot].dense = (std::uint32_t)values.size();
+		values.push_back(value);
+		valueSlots.push_back(slot);
+		return SlotHandle{ slot, slots[slot].generation };
+	}
+
+	// Returns false if the handle was already stale
+	bool remove(SlotHandle handle)
+	{
+		if (!contains(handle)) return false;
+
+		// Move the last value into the gap so the storage stays packed
+		std::uint32_t dense = slots[handle.index].dense;
+		std::uint32_t last = (std::uint32_t)values.size() - 1;
+		if (dense != last) {
+			values[dense] = std::move(values[last]);
+			valueSlots[dense] = valueSlots[last];
+			slots[valueSlots[dense]].dense = dense;
+		}
+		values.pop_back();
+		valueSlots.pop_back();
+
+		// A new generation makes every handle to the old value stale, then the slot goes on the free list
+		++slots[handle.index].generation;
+		slots[handle.index].dense = freeList;
+		freeList = handle.index;
+		return true;
+	}
+
+	bool contains(SlotHandle handle) const
+	{
+		return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+	}
+
+	// Value for the handle, or nullptr if the handle is stale
+	T* get(SlotHandle handle) { return contains(handle) ? &values[slots[handle.index].dense] : nullptr; }
+	const T* get(SlotHandle handle) const { return contains(handle) ? &values[slots[handle.index].dense] : nullptr; }
+
+	void clear()
+	{
+		for (std::uint32_t slot : valueSlots) {
+			++slots[slot].generation;
+			slots[slot].dense = freeList;
+			freeList = slot;
+		}
+		values.clear();
+		valueSlots.clear();
+	}
+
+	int size() const { return (int)values.size(); }
+	bool empty() const { return values.empty(); }
+
+	// Iterates the values in storage order, which changes as values are removed
+	typename std::vector<T>::iterator begin() { return values.begin(); }
+	typename std::vector<T>::iterator end() { return values.end(); }
+	typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+	typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+	static const std::uint32_t none = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		std::uint32_t dense = 0;		// index of the value, or the next free slot while free
+		std::uint32_t generation = 0;
+	};
+
+	std::vector<T> values;
+	std::vector<std::uint32_t> valueSlots;	// slot of each value
+	std::vector<Slot> slots;
+	std::uint32_t freeList = none;
+};
@@ -0,0 +1,229 @@
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+// Removed entries keep their place in the sorted list until it is compacted
+static const int deadId = -1;
+
+SpatialHash::SpatialHash(float size)
+{
+    sorted = true;
+    deadCount = 0;
+    setCellSize(size);
+}
+
+void SpatialHash::setCellSize(float size)
+{
+    cellSize = size > 0.f ? size : 1.f;
+    inverseCellSize = 1.f / cellSize;
+    clear();
+}
+
+void SpatialHash::clear()
+{
+    entries.clear();
+    recent.clear();
+    deadCount = 0;
+    sorted = true;
+}
+
+// Packs the two cell coordinates into a single sortable key
+std::int64_t SpatialHash::cellKey(int cx, int cy) const
+{
+    return (static_cast<std::int64_t>(cx) << 32) | static_cast<std::uint32_t>(cy);
+}
+
+void SpatialHash::getCellRange(const sf::FloatRect& box, int& minX, int& minY, int& maxX, int& maxY) const
+{
+    // Boxes may have a negative width/height, sf::FloatRect::intersects allows this so we do too
+    float left = std::min(box.left, box.left + box.width);
+    float right = std::max(box.left, box.left + box.width);
+    float top = std::min(box.top, box.top + box.height);
+    float bottom = std::max(box.top, box.top + box.height);
+
+    minX = static_cast<int>(std::floor(left * inverseCellSize));
+    maxX = static_cast<int>(std::floor(right * inverseCellSize));
+    minY = static_cast<int>(std::floor(top * inverseCellSize));
+    maxY = static_cast<int>(std::floor(bottom * inverseCellSize));
+}
+
+void SpatialHash::insert(int id, const sf::FloatRect& box)
+{
+    int minX, minY, maxX, maxY;
+    getCellRange(box, minX, minY, maxX, maxY);
+
+    for (int cx = minX; cx <= maxX; ++cx)
+    {
+        for (int cy = minY; cy <= maxY; ++cy)
+        {
+            entries.push_back({ cellKey(cx, cy), id });
+        }
+    }
+    sorted = false;
+}
+
+void SpatialHash::add(int id, const sf::FloatRect& box)
+{
+    // Entries from insert are sorted in first, so both lists stay sorted from here on
+    sortEntries();
+
+    int minX, minY, maxX, maxY;
+    getCellRange(box, minX, minY, maxX, maxY);
+
+    for (int cx = minX; cx <= maxX; ++cx)
+    {
+        for (int cy = minY; cy <= maxY; ++cy)
+        {
+            Entry entry = { cellKey(cx, cy), id };
+            recent.insert(std::upper_bound(recent.begin(), recent.end(), entry, keyLess), entry);
+        }
+    }
+
+    // Merging costs the whole list, inserting costs the recent list. Letting the recent list grow to about the square root of
+    // the whole keeps both cheap
+    if (recent.size() > 64 + (size_t)std::sqrt((double)entries.size()))
+    {
+        mergeRecent();
+    }
+}
+
+void SpatialHash::remove(int id, const sf::FloatRect& box)
+{
+    sortEntries();
+
+    int minX, minY, maxX, maxY;
+    getCellRange(box, minX, minY, maxX, maxY);
+
+    for (int cx = minX; cx <= maxX; ++cx)
+    {
+        for (int cy = minY; cy <= maxY; ++cy)
+        {
+            Entry key = { cellKey(cx, cy), id };
+
+            // Still in the recent list, which is short enough to erase from
+            bool found = false;
+            auto it = std::lower_bound(recent.begin(), recent.end(), key, keyLess);
+            for (; it != recent.end() && it->key == key.key; ++it)
+            {
+                if (it->id == id)
+                {
+                    recent.erase(it);
+                    found = true;
+                    break;
+                }
+            }
+            if (found) continue;
+
+            it = std::lower_bound(entries.begin(), entries.end(), key, keyLess);
+            for (; it != entries.end() && it->key == key.key; ++it)
+            {
+                if (it->id == id)
+                {
+                    it->id = deadId;
+                    ++deadCount;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Compacted once half the list is dead, so a removal costs a constant amount on average
+    if (deadCount * 2 > (int)entries.size())
+    {
+        dropDead();
+    }
+}
+
+void SpatialHash::mergeRecent()
+{
+    size_t middle = entries.size();
+    entries.insert(entries.end(), recent.begin(), recent.end());
+    std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end(), keyLess);
+    recent.clear();
+}
+
+void SpatialHash::dropDead()
+{
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& e) { return e.id == deadId; }), entries.end());
+    deadCount = 0;
+}
+
+void SpatialHash::sortEntries()
+{
+    if (sorted) return;
+
+    // Sorting by key groups each cell together, ids stay ascending inside a cell
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+        {
+            return a.key < b.key || (a.key == b.key && a.id < b.id);
+        });
+    sorted = true;
+}
+
+void SpatialHash::getPairs(std::vector<std::pair<int, int>>& pairs)
+{
+    pairs.clear();
+    sortEntries();
+    // Only lists that were added to or removed from need this, a rebuilt hash has neither
+    if (!recent.empty()) mergeRecent();
+    if (deadCount > 0) dropDead();
+
+    // Walk each run of entries that share a cell and pair everything in it
+    size_t start = 0;
+    while (start < entries.size())
+    {
+        size_t end = start + 1;
+        while (end < entries.size() && entries[end].key == entries[start].key)
+        {
+            ++end;
+        }
+
+        for (size_t i = start; i < end; ++i)
+        {
+            for (size_t j = i + 1; j < end; ++j)
+            {
+                // Merged entries are only sorted by key, so the lower id is not always first
+                int a = entries[i].id;
+                int b = entries[j].id;
+                if (a != b)
+                {
+                    pairs.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+                }
+            }
+        }
+        start = end;
+    }
+
+    // Objects covering several cells together are found once per shared cell
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+}
+
+void SpatialHash::query(const sf::FloatRect& box, std::vector<int>& results)
+{
+    sortEntries();
+
+    int minX, minY, maxX, maxY;
+    getCellRange(box, minX, minY, maxX, maxY);
+
+    for (int cx = minX; cx <= maxX; ++cx)
+    {
+        for (int cy = minY; cy <= maxY; ++cy)
+        {
+            Entry key = { cellKey(cx, cy), 0 };
+            auto it = std::lower_bound(entries.begin(), entries.end(), key, keyLess);
+            for (; it != entries.end() && it->key == key.key; ++it)
+            {
+                if (it->id != deadId)
+                {
+                    results.push_back(it->id);
+                }
+            }
+            it = std::lower_bound(recent.begin(), recent.end(), key, keyLess);
+            for (; it != recent.end() && it->key == key.key; ++it)
+            {
+                results.push_back(it->id);
+            }
+        }
+    }
+}
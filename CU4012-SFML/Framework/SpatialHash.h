@@ -0,0 +1,60 @@
+// Spatial Hash Class
+// Uniform grid broadphase used by the World to avoid testing every object against every other object.
+// Objects are bucketed by the grid cells their collision box covers, only objects sharing a cell are reported as potential pairs.
+// Cells are stored as a flat list of (cell key, object id) entries sorted by key, so rebuilding every step does not allocate once warmed up.
+// A hash that is kept rather than rebuilt can also have single objects added and removed without sorting everything again.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+class SpatialHash
+{
+public:
+	SpatialHash(float size = 128.f);
+
+	// Cell size in world units. Should be roughly the size of the common moving objects.
+	void setCellSize(float size);
+	float getCellSize() const { return cellSize; }
+
+	// Remove all entries, keeps allocated memory for the next rebuild
+	void clear();
+	// Add an object id covering the given box. For building a hash in one go, the entries are sorted at the next query
+	void insert(int id, const sf::FloatRect& box);
+	// Add or remove one object of a built hash. Added entries wait in a short sorted list that is merged in once it grows,
+	// removed ones are marked dead and dropped once they are half of the list. The box must be the one the id was added with
+	void add(int id, const sf::FloatRect& box);
+	void remove(int id, const sf::FloatRect& box);
+
+	// Fills pairs with every pair of ids sharing at least one cell.
+	// Each pair is reported once with the lower id first, sorted in ascending order.
+	void getPairs(std::vector<std::pair<int, int>>& pairs);
+
+	// Fills results with the ids stored in every cell the box covers (may contain duplicates)
+	void query(const sf::FloatRect& box, std::vector<int>& results);
+
+	int getEntryCount() const { return (int)(entries.size() + recent.size()) - deadCount; }
+
+private:
+	struct Entry
+	{
+		std::int64_t key;
+		int id;
+	};
+
+	static bool keyLess(const Entry& a, const Entry& b) { return a.key < b.key; }
+	std::int64_t cellKey(int cx, int cy) const;
+	void getCellRange(const sf::FloatRect& box, int& minX, int& minY, int& maxX, int& maxY) const;
+	void sortEntries();
+	void mergeRecent();
+	void dropDead();
+
+	float cellSize;
+	float inverseCellSize;
+	std::vector<Entry> entries;
+	bool sorted;
+	std::vector<Entry> recent;	// entries from add not merged yet, sorted by key
+	int deadCount;				// removed entries still in the list, their id is -1
+};
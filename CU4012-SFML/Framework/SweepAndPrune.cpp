@@ -0,0 +1,298 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+#include <limits>
+
+SweepAndPrune::SweepAndPrune()
+{
+    proxyCount = 0;
+}
+
+int SweepAndPrune::createProxy(const sf::FloatRect& box)
+{
+    int proxy;
+    if (!freeProxies.empty()) {
+        proxy = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    else {
+        proxy = (int)proxies.size();
+        proxies.push_back(Proxy());
+    }
+
+    Proxy& p = proxies[proxy];
+    p.alive = true;
+    p.inserted = false;
+    p.moved = false;
+    moveProxy(proxy, box);
+
+    // The endpoints go in on the next update
+    createdProxies.push_back(proxy);
+    ++proxyCount;
+    return proxy;
+}
+
+void SweepAndPrune::destroyProxy(int proxy)
+{
+    if (proxy < 0 || proxy >= (int)proxies.size() || !proxies[proxy].alive) return;
+
+    // Endpoints are taken out in the next update
+    proxies[proxy].alive = false;
+    destroyedProxies.push_back(proxy);
+    --proxyCount;
+}
+
+void SweepAndPrune::moveProxy(int proxy, const sf::FloatRect& box)
+{
+    Proxy& p = proxies[proxy];
+    float minX = std::min(box.left, box.left + box.width);
+    float maxX = std::max(box.left, box.left + box.width);
+    float minY = std::min(box.top, box.top + box.height);
+    float maxY = std::max(box.top, box.top + box.height);
+    if (p.inserted && p.min[0] == minX && p.max[0] == maxX && p.min[1] == minY && p.max[1] == maxY) return;
+
+    p.min[0] = minX;
+    p.max[0] = maxX;
+    p.min[1] = minY;
+    p.max[1] = maxY;
+    if (p.inserted && !p.moved) {
+        p.moved = true;
+        movedProxies.push_back(proxy);
+    }
+}
+
+void SweepAndPrune::clear()
+{
+    proxies.clear();
+    freeProxies.clear();
+    createdProxies.clear();
+    movedProxies.clear();
+    destroyedProxies.clear();
+    endpoints[0].clear();
+    endpoints[1].clear();
+    pairSet.clear();
+    changedPairs.clear();
+    pairs.clear();
+    addedPairs.clear();
+    removedPairs.clear();
+    proxyCount = 0;
+}
+
+void SweepAndPrune::addPair(int a, int b)
+{
+    if (a == b || !proxies[a].alive || !proxies[b].alive) return;
+    if (!overlaps(proxies[a], proxies[b])) return;
+
+    std::uint64_t key = pairKey(a, b);
+    if (pairSet.insert(key).second) {
+        changedPairs.emplace(key, false);
+    }
+}
+
+void SweepAndPrune::removePair(int a, int b)
+{
+    if (a == b) return;
+
+    std::uint64_t key = pairKey(a, b);
+    if (pairSet.erase(key)) {
+        changedPairs.emplace(key, true);
+    }
+}
+
+void SweepAndPrune::setIndex(int axis, int index)
+{
+    const Endpoint& e = endpoints[axis][index];
+    if (e.isMin) {
+        proxies[e.proxy].minIndex[axis] = index;
+    }
+    else {
+        proxies[e.proxy].maxIndex[axis] = index;
+    }
+}
+
+void SweepAndPrune::swapEndpoints(int axis, int index)
+{
+    // The endpoint at index + 1 moves below the one at index. A min moving below a max means the two boxes now overlap on this axis,
+    // a max moving below a min means they no longer do. Two mins or two maxes passing each other changes nothing
+    std::vector<Endpoint>& list = endpoints[axis];
+    const Endpoint& lower = list[index];
+    const Endpoint& upper = list[index + 1];
+    if (upper.isMin && !lower.isMin) {
+        addPair(upper.proxy, lower.proxy);
+    }
+    else if (!upper.isMin && lower.isMin) {
+        removePair(upper.proxy, lower.proxy);
+    }
+
+    std::swap(list[index], list[index + 1]);
+    setIndex(axis, index);
+    setIndex(axis, index + 1);
+}
+
+void SweepAndPrune::shift(int axis, int index)
+{
+    // Insertion sort of one endpoint, close to no swaps because objects only move a little between steps
+    std::vector<Endpoint>& list = endpoints[axis];
+    Endpoint& e = list[index];
+    e.value = e.isMin ? proxies[e.proxy].min[axis] : proxies[e.proxy].max[axis];
+
+    while (index > 0 && endpointLess(list[index], list[index - 1])) {
+        swapEndpoints(axis, index - 1);
+        --index;
+    }
+    while (index + 1 < (int)list.size() && endpointLess(list[index + 1], list[index])) {
+        swapEndpoints(axis, index);
+        ++index;
+    }
+}
+
+void SweepAndPrune::shiftProxy(int proxy)
+{
+    for (int axis = 0; axis < 2; ++axis) {
+        // Moving right the max leads so the min never has to pass it, moving left the min leads
+        const Proxy& p = proxies[proxy];
+        bool movingRight = p.min[axis] > endpoints[axis][p.minIndex[axis]].value;
+        if (movingRight) {
+            shift(axis, p.maxIndex[axis]);
+            shift(axis, proxies[proxy].minIndex[axis]);
+        }
+        else {
+            shift(axis, p.minIndex[axis]);
+            shift(axis, proxies[proxy].maxIndex[axis]);
+        }
+    }
+}
+
+void SweepAndPrune::insertProxy(int proxy)
+{
+    // Added on the end and shifted down into place, finding its pairs on the way
+    Proxy& p = proxies[proxy];
+    for (int axis = 0; axis < 2; ++axis) {
+        std::vector<Endpoint>& list = endpoints[axis];
+        list.push_back({ p.min[axis], proxy, true });
+        p.minIndex[axis] = (int)list.size() - 1;
+        shift(axis, p.minIndex[axis]);
+        list.push_back({ p.max[axis], proxy, false });
+        p.maxIndex[axis] = (int)list.size() - 1;
+        shift(axis, p.maxIndex[axis]);
+    }
+    p.inserted = true;
+}
+
+void SweepAndPrune::removeProxy(int proxy)
+{
+    // Shifted off the top end, which removes its pairs on the way, then dropped
+    Proxy& p = proxies[proxy];
+    const float top = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 2; ++axis) {
+        p.min[axis] = top;
+        p.max[axis] = top;
+        shift(axis, p.maxIndex[axis]);
+        shift(axis, p.minIndex[axis]);
+        std::vector<Endpoint>& list = endpoints[axis];
+        while (!list.empty() && list.back().proxy == proxy) {
+            list.pop_back();
+        }
+    }
+    p.inserted = false;
+}
+
+void SweepAndPrune::rebuild()
+{
+    // Sorts the lists from scratch and sweeps for every pair, for when so many proxies come or go at once (e.g. loading a level)
+    // that shifting them in one by one would be quadratic
+    for (int axis = 0; axis < 2; ++axis) {
+        std::vector<Endpoint>& list = endpoints[axis];
+        list.clear();
+        for (int proxy = 0; proxy < (int)proxies.size(); ++proxy) {
+            Proxy& p = proxies[proxy];
+            p.inserted = p.alive;
+            p.moved = false;
+            if (!p.alive) continue;
+            list.push_back({ p.min[axis], proxy, true });
+            list.push_back({ p.max[axis], proxy, false });
+        }
+        std::sort(list.begin(), list.end(), endpointLess);
+        for (int i = 0; i < (int)list.size(); ++i) {
+            setIndex(axis, i);
+        }
+    }
+
+    std::unordered_set<std::uint64_t> previous;
+    previous.swap(pairSet);
+    active.clear();
+    for (const Endpoint& e : endpoints[0]) {
+        if (e.isMin) {
+            // Everything still active overlaps on x, addPair tests y
+            for (int other : active) {
+                addPair(e.proxy, other);
+            }
+            active.push_back(e.proxy);
+        }
+        else {
+            active.erase(std::find(active.begin(), active.end(), e.proxy));
+        }
+    }
+
+    // Pairs found by the sweep were recorded as new, correct that against what there was before
+    for (auto it = changedPairs.begin(); it != changedPairs.end();) {
+        if (previous.count(it->first)) {
+            it = changedPairs.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    for (std::uint64_t key : previous) {
+        if (!pairSet.count(key)) {
+            changedPairs.emplace(key, true);
+        }
+    }
+}
+
+void SweepAndPrune::update()
+{
+    changedPairs.clear();
+
+    if (createdProxies.size() + destroyedProxies.size() > 64) {
+        rebuild();
+    }
+    else {
+        for (int proxy : destroyedProxies) {
+            if (proxies[proxy].inserted) removeProxy(proxy);
+        }
+        for (int proxy : movedProxies) {
+            if (proxies[proxy].alive && proxies[proxy].inserted) shiftProxy(proxy);
+        }
+        for (int proxy : createdProxies) {
+            if (proxies[proxy].alive && !proxies[proxy].inserted) insertProxy(proxy);
+        }
+    }
+    for (int proxy : movedProxies) {
+        proxies[proxy].moved = false;
+    }
+    createdProxies.clear();
+    movedProxies.clear();
+
+    // Report the pairs whose state is different from the start of the update, a pair added and removed again is not reported
+    addedPairs.clear();
+    removedPairs.clear();
+    for (auto& changed : changedPairs) {
+        bool present = pairSet.count(changed.first) != 0;
+        if (present == changed.second) continue;
+        std::pair<int, int> pair((int)(changed.first >> 32), (int)(changed.first & 0xFFFFFFFFu));
+        (present ? addedPairs : removedPairs).push_back(pair);
+    }
+    std::sort(addedPairs.begin(), addedPairs.end());
+    std::sort(removedPairs.begin(), removedPairs.end());
+
+    pairs.clear();
+    pairs.reserve(pairSet.size());
+    for (std::uint64_t key : pairSet) {
+        pairs.push_back(std::make_pair((int)(key >> 32), (int)(key & 0xFFFFFFFFu)));
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    // Destroyed proxies have had their pairs removed, their ids can be reused now
+    freeProxies.insert(freeProxies.end(), destroyedProxies.begin(), destroyedProxies.end());
+    destroyedProxies.clear();
+}
@@ -0,0 +1,96 @@
+// Sweep And Prune Class
+// Broadphase that keeps the min/max endpoints of every proxy box in a sorted list for each axis between steps.
+// Objects move a little each frame, so only the endpoints of the proxies that moved are shifted into place. Each time a min endpoint
+// passes a max endpoint two boxes start or stop overlapping on that axis, so the overlapping pairs are kept up to date from those swaps
+// alone rather than found again every step, and proxies that do not move cost nothing. Pairs that began and ended in an update are
+// reported as added/removed pairs.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <unordered_set>
+#include <unordered_map>
+
+class SweepAndPrune
+{
+public:
+	SweepAndPrune();
+
+	// Proxy management, a proxy is the broadphase representation of one object
+	int createProxy(const sf::FloatRect& box);
+	void destroyProxy(int proxy);
+	void moveProxy(int proxy, const sf::FloatRect& box);
+	void clear();
+
+	// Moves the endpoints of the proxies created, moved or destroyed since the last update into place, updating the pairs as they go.
+	// Call once per step after moving the proxies.
+	void update();
+
+	// Every overlapping pair (lower proxy first), sorted in ascending order
+	const std::vector<std::pair<int, int>>& getPairs() const { return pairs; }
+	// Pairs that started overlapping this update
+	const std::vector<std::pair<int, int>>& getAddedPairs() const { return addedPairs; }
+	// Pairs that stopped overlapping this update (or lost one of their proxies)
+	const std::vector<std::pair<int, int>>& getRemovedPairs() const { return removedPairs; }
+
+	int getProxyCount() const { return proxyCount; }
+
+private:
+	struct Proxy
+	{
+		float min[2], max[2];
+		int minIndex[2], maxIndex[2];	// where its endpoints are in each axis list
+		bool alive;
+		bool inserted;		// its endpoints are in the lists
+		bool moved;			// in the moved list for the next update
+	};
+
+	struct Endpoint
+	{
+		float value;
+		int proxy;
+		bool isMin;
+	};
+
+	// Sort order of the endpoints. Min endpoints come first on a tie so touching boxes are reported
+	static bool endpointLess(const Endpoint& a, const Endpoint& b)
+	{
+		return a.value < b.value || (a.value == b.value && a.isMin && !b.isMin);
+	}
+	static std::uint64_t pairKey(int a, int b)
+	{
+		if (a > b) std::swap(a, b);
+		return ((std::uint64_t)(std::uint32_t)a << 32) | (std::uint32_t)b;
+	}
+
+	bool overlaps(const Proxy& a, const Proxy& b) const
+	{
+		return a.min[0] <= b.max[0] && b.min[0] <= a.max[0] && a.min[1] <= b.max[1] && b.min[1] <= a.max[1];
+	}
+	void setIndex(int axis, int index);
+	void swapEndpoints(int axis, int index);
+	void shift(int axis, int index);
+	void shiftProxy(int proxy);
+	void insertProxy(int proxy);
+	void removeProxy(int proxy);
+	void rebuild();
+	void addPair(int a, int b);
+	void removePair(int a, int b);
+
+	std::vector<Proxy> proxies;
+	std::vector<int> freeProxies;
+	std::vector<int> createdProxies;
+	std::vector<int> movedProxies;
+	std::vector<int> destroyedProxies;	// only reused after the next update, so their removed pairs are still reported
+	int proxyCount;
+	std::vector<Endpoint> endpoints[2];
+
+	std::unordered_set<std::uint64_t> pairSet;
+	std::unordered_map<std::uint64_t, bool> changedPairs;	// pairs touched this update, and whether they were there before it
+	std::vector<int> active;
+	std::vector<std::pair<int, int>> pairs;
+	std::vector<std::pair<int, int>> addedPairs;
+	std::vector<std::pair<int, int>> removedPairs;
+};
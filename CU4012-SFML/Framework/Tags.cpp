@@ -0,0 +1,41 @@
+#include "Tags.h"
+
+// Function local tables so tags can be interned from other static objects' constructors
+std::vector<std::string>& Tags::names()
+{
+    static std::vector<std::string> table{ "" };
+    return table;
+}
+
+std::unordered_map<std::string, int>& Tags::ids()
+{
+    static std::unordered_map<std::string, int> table{ { "", None } };
+    return table;
+}
+
+int Tags::getId(const std::string& name)
+{
+    auto it = ids().find(name);
+    if (it != ids().end()) {
+        return it->second;
+    }
+
+    int id = (int)names().size();
+    names().push_back(name);
+    ids()[name] = id;
+    return id;
+}
+
+int Tags::findId(const std::string& name)
+{
+    auto it = ids().find(name);
+    return it != ids().end() ? it->second : -1;
+}
+
+const std::string& Tags::getName(int id)
+{
+    if (id < 0 || id >= (int)names().size()) {
+        return names()[None];
+    }
+    return names()[id];
+}
@@ -0,0 +1,26 @@
+// Tags Class
+// Global table interning tag strings as small integer ids.
+// GameObjects store the id, so comparing, clearing and copying tags during collision is integer work.
+// Id 0 is always the empty tag.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class Tags
+{
+public:
+	// Returns the id for the tag, adding it to the table the first time it is seen
+	static int getId(const std::string& name);
+	// Returns the id for the tag without adding it, -1 if the tag has never been used
+	static int findId(const std::string& name);
+	// Returns the tag string for an id
+	static const std::string& getName(int id);
+
+	static const int None = 0;
+
+private:
+	static std::vector<std::string>& names();
+	static std::unordered_map<std::string, int>& ids();
+};
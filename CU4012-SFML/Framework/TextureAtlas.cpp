@@ -0,0 +1,152 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <iostream>
+
+// ImGui builds its own copy of the packer as static functions in imgui_draw.cpp, this file does the same so the two never clash
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+TextureAtlas::TextureAtlas()
+{
+    pageSize = 2048;
+    padding = 2;
+    smooth = false;
+}
+
+void TextureAtlas::setSmooth(bool s)
+{
+    smooth = s;
+    for (auto& page : pages) {
+        page->setSmooth(s);
+    }
+}
+
+void TextureAtlas::add(const std::string& name, const sf::Image& image)
+{
+    for (auto& entry : pending) {
+        if (entry.first == name) {
+            entry.second = image;
+            return;
+        }
+    }
+    pending.push_back({ name, image });
+}
+
+void TextureAtlas::clear()
+{
+    pending.clear();
+    pages.clear();
+    regions.clear();
+}
+
+// Copies an image into a page at x, y and repeats its outer rows and columns out into the padding around it
+static void blitExtruded(sf::Image& page, const sf::Image& image, unsigned int x, unsigned int y, unsigned int padding)
+{
+    sf::Vector2u size = image.getSize();
+    page.copy(image, x, y);
+    if (size.x == 0 || size.y == 0) return;
+
+    for (unsigned int i = 1; i <= padding; ++i) {
+        page.copy(image, x, y - i, sf::IntRect(0, 0, size.x, 1));
+        page.copy(image, x, y + size.y - 1 + i, sf::IntRect(0, size.y - 1, size.x, 1));
+        page.copy(image, x - i, y, sf::IntRect(0, 0, 1, size.y));
+        page.copy(image, x + size.x - 1 + i, y, sf::IntRect(size.x - 1, 0, 1, size.y));
+    }
+
+    // Corners take the corner pixel
+    sf::Color corners[4] = {
+        image.getPixel(0, 0), image.getPixel(size.x - 1, 0), image.getPixel(0, size.y - 1), image.getPixel(size.x - 1, size.y - 1)
+    };
+    for (unsigned int dy = 1; dy <= padding; ++dy) {
+        for (unsigned int dx = 1; dx <= padding; ++dx) {
+            page.setPixel(x - dx, y - dy, corners[0]);
+            page.setPixel(x + size.x - 1 + dx, y - dy, corners[1]);
+            page.setPixel(x - dx, y + size.y - 1 + dy, corners[2]);
+            page.setPixel(x + size.x - 1 + dx, y + size.y - 1 + dy, corners[3]);
+        }
+    }
+}
+
+bool TextureAtlas::build()
+{
+    pages.clear();
+    regions.clear();
+
+    const int maxSize = (int)std::min(pageSize, sf::Texture::getMaximumSize());
+    const int border = (int)padding;
+
+    // Every image with its padding on each side, the id is its index in the queue
+    std::vector<stbrp_rect> remaining;
+    for (int i = 0; i < (int)pending.size(); ++i) {
+        sf::Vector2u size = pending[i].second.getSize();
+        stbrp_rect rect = {};
+        rect.id = i;
+        rect.w = (int)size.x + border * 2;
+        rect.h = (int)size.y + border * 2;
+        remaining.push_back(rect);
+    }
+
+    std::vector<stbrp_node> nodes;
+    while (!remaining.empty()) {
+        // A page grows to fit an image too big for a normal one
+        int width = maxSize;
+        int height = maxSize;
+        for (auto& rect : remaining) {
+            width = std::max(width, (int)rect.w);
+            height = std::max(height, (int)rect.h);
+        }
+
+        stbrp_context context;
+        nodes.resize(width);
+        stbrp_init_target(&context, width, height, nodes.data(), (int)nodes.size());
+        stbrp_pack_rects(&context, remaining.data(), (int)remaining.size());
+
+        // Trim the page to the rows that were used
+        int usedWidth = 1;
+        int usedHeight = 1;
+        for (auto& rect : remaining) {
+            if (!rect.was_packed) continue;
+            usedWidth = std::max(usedWidth, rect.x + rect.w);
+            usedHeight = std::max(usedHeight, rect.y + rect.h);
+        }
+
+        sf::Image image;
+        image.create(usedWidth, usedHeight, sf::Color::Transparent);
+        int page = (int)pages.size();
+        std::vector<stbrp_rect> next;
+        for (auto& rect : remaining) {
+            if (!rect.was_packed) {
+                next.push_back(rect);
+                continue;
+            }
+            const sf::Image& source = pending[rect.id].second;
+            blitExtruded(image, source, rect.x + border, rect.y + border, padding);
+            sf::Vector2u size = source.getSize();
+            regions[pending[rect.id].first] = { page, nullptr, sf::IntRect(rect.x + border, rect.y + border, (int)size.x, (int)size.y) };
+        }
+
+        auto texture = std::make_unique<sf::Texture>();
+        if (!texture->loadFromImage(image)) {
+            std::cerr << "Failed to create texture atlas page " << page << std::endl;
+            regions.clear();
+            pages.clear();
+            return false;
+        }
+        texture->setSmooth(smooth);
+        pages.push_back(std::move(texture));
+        remaining.swap(next);
+    }
+
+    // The pages have their final addresses now
+    for (auto& region : regions) {
+        region.second.texture = pages[region.second.page].get();
+    }
+    return true;
+}
+
+const TextureAtlas::Region* TextureAtlas::find(const std::string& name) const
+{
+    auto it = regions.find(name);
+    return it != regions.end() ? &it->second : nullptr;
+}
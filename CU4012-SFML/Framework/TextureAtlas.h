@@ -0,0 +1,51 @@
+// Texture Atlas Class
+// Packs many small images into a few large textures (pages) at load time, so sprites using different images can share a draw call.
+// Images are placed with the stb rect packer vendored with ImGui. Each one is surrounded by padding filled with copies of its edge pixels,
+// so smoothing or scaling never samples a neighbouring image at the edges.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TextureAtlas
+{
+public:
+	// Where an image ended up: the page texture it is on and its rect in pixels, the padding not included
+	struct Region
+	{
+		int page;
+		const sf::Texture* texture;
+		sf::IntRect rect;
+	};
+
+	TextureAtlas();
+
+	// Largest page width and height, clamped to what the graphics card allows. A page grows to fit an image bigger than this
+	void setPageSize(unsigned int size) { pageSize = size; }
+	// Pixels of extruded edge around each image
+	void setPadding(unsigned int p) { padding = p; }
+	// Texture smoothing for the pages, only safe to turn on because of the padding
+	void setSmooth(bool s);
+
+	// Queues an image to be packed under a name, a name already queued is replaced
+	void add(const std::string& name, const sf::Image& image);
+	// Packs everything queued into pages and uploads them, replacing any earlier build. Returns false if a page could not be created
+	bool build();
+	void clear();
+
+	// nullptr if nothing by that name was packed
+	const Region* find(const std::string& name) const;
+	int getPageCount() const { return (int)pages.size(); }
+	const sf::Texture& getPage(int page) const { return *pages[page]; }
+
+private:
+	std::vector<std::pair<std::string, sf::Image>> pending;
+	std::vector<std::unique_ptr<sf::Texture>> pages;
+	std::unordered_map<std::string, Region> regions;
+	unsigned int pageSize;
+	unsigned int padding;
+	bool smooth;
+};
@@ -3,11 +3,14 @@
 #include <vector>
 #include <unordered_map>
 #include <iostream>
+#include "TextureAtlas.h"
 
 namespace fs = std::filesystem;
 
+// Loads every image in a directory into a texture atlas, so tiles using different images still share a draw call.
+// Tiles point at an atlas page with the image's rect on it rather than at a texture of their own
 class TextureManager {
-    std::unordered_map<std::string, sf::Texture> textures;
+    TextureAtlas atlas;
     std::vector<std::string> names;
 
 public:
@@ -21,10 +24,10 @@ public:
 
         for (const auto& entry : fs::directory_iterator(dir_path)) {
             if (fs::is_regular_file(entry) && hasSupportedExtension(entry.path().extension().string())) {
-                sf::Texture texture;
-                if (texture.loadFromFile(entry.path().string())) {
+                sf::Image image;
+                if (image.loadFromFile(entry.path().string())) {
                     std::string filename = entry.path().filename().string();
-                    textures[filename] = std::move(texture);
+                    atlas.add(filename, image);
                     names.push_back(filename);
                     std::cout << "Loaded texture: " << filename << std::endl;
                 }
@@ -33,6 +36,10 @@ public:
 				}
             }
         }
+
+        if (atlas.build()) {
+            std::cout << "Packed " << names.size() << " textures into " << atlas.getPageCount() << " atlas page(s)" << std::endl;
+        }
     }
 
     bool hasSupportedExtension(const std::string& ext) const {
@@ -43,11 +50,23 @@ public:
         return names;
     }
 
-    sf::Texture* getTexture(const std::string& name) {
-        auto it = textures.find(name);
-        if (it != textures.end()) {
-            return &it->second;
+    // Atlas page and rect of a loaded image, nullptr if there is none by that name
+    const TextureAtlas::Region* getRegion(const std::string& name) const {
+        return atlas.find(name);
+    }
+
+    // Points a shape at an image's page and rect. Returns false and leaves the shape alone if there is no image by that name
+    bool applyTexture(sf::Shape& shape, const std::string& name) const {
+        const TextureAtlas::Region* region = atlas.find(name);
+        if (!region) {
+            return false;
         }
-        return nullptr;
+        shape.setTexture(region->texture);
+        shape.setTextureRect(region->rect);
+        return true;
+    }
+
+    const TextureAtlas& getAtlas() const {
+        return atlas;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,120 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int count)
+{
+    threadCount = 1;
+    currentJob = nullptr;
+    jobCount = 0;
+    generation = 0;
+    pending = 0;
+    stopping = false;
+    setThreadCount(count);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopWorkers();
+}
+
+void ThreadPool::setThreadCount(int count)
+{
+    if (count <= 0) {
+        count = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    if (count == threadCount && (int)workers.size() == count - 1) return;
+
+    stopWorkers();
+    threadCount = count;
+    startWorkers();
+}
+
+void ThreadPool::startWorkers()
+{
+    stopping = false;
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i, generation);
+    }
+}
+
+void ThreadPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+// Splits [0, count) into threadCount ranges that differ in size by at most one
+static void getRange(int count, int threadCount, int threadIndex, int& begin, int& end)
+{
+    int size = count / threadCount;
+    int remainder = count % threadCount;
+    begin = threadIndex * size + std::min(threadIndex, remainder);
+    end = begin + size + (threadIndex < remainder ? 1 : 0);
+}
+
+// startGeneration is the generation when the worker was created, so it only picks up work given after that
+void ThreadPool::workerLoop(int threadIndex, int startGeneration)
+{
+    int seenGeneration = startGeneration;
+    while (true) {
+        const std::function<void(int, int, int)>* job;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            job = currentJob;
+            count = jobCount;
+        }
+
+        int begin, end;
+        getRange(count, threadCount, threadIndex, begin, end);
+        if (begin < end) {
+            (*job)(begin, end, threadIndex);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --pending;
+        }
+        workDone.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int, int)>& job)
+{
+    if (count <= 0) return;
+
+    if (workers.empty()) {
+        job(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = &job;
+        jobCount = count;
+        pending = (int)workers.size();
+        ++generation;
+    }
+    workReady.notify_all();
+
+    // The calling thread does the first range while the workers do the rest
+    int begin, end;
+    getRange(count, threadCount, 0, begin, end);
+    if (begin < end) {
+        job(begin, end, 0);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pending == 0; });
+    currentJob = nullptr;
+}
@@ -0,0 +1,47 @@
+// Thread Pool Class
+// Small pool of worker threads for splitting loops over several cores.
+// parallelFor hands each thread one contiguous range of the loop and waits for them all, the calling thread takes the first range.
+// The ranges only depend on the count and the thread count, so jobs that write into per-thread buffers can merge them in a fixed order.
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool
+{
+public:
+	// 0 threads uses one per hardware core
+	ThreadPool(int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Total threads used by parallelFor, including the calling thread. 1 runs everything on the calling thread
+	void setThreadCount(int count);
+	int getThreadCount() const { return threadCount; }
+
+	// Calls job(begin, end, threadIndex) once per thread over [0, count) and returns when every range is done.
+	// Range i is always given to thread index i. Must not be called from inside a job
+	void parallelFor(int count, const std::function<void(int, int, int)>& job);
+
+private:
+	void startWorkers();
+	void stopWorkers();
+	void workerLoop(int threadIndex, int startGeneration);
+
+	int threadCount;
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	const std::function<void(int, int, int)>* currentJob;
+	int jobCount;
+	int generation;		// bumped for every parallelFor so workers know there is new work
+	int pending;		// workers still running the current job
+	bool stopping;
+};
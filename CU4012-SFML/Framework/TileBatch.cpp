@@ -0,0 +1,113 @@
+#include "TileBatch.h"
+#include <algorithm>
+#include <cmath>
+
+void TileBatch::clear()
+{
+    for (auto& chunk : chunks) {
+        for (auto& group : chunk.groups) {
+            group.vertices.clear();
+        }
+        chunk.tileCount = 0;
+    }
+    tileCount = 0;
+}
+
+void TileBatch::add(const sf::RectangleShape& tile)
+{
+    const sf::Texture* texture = tile.getTexture();
+    if (!texture) return;
+
+    // The shape's corners in the same order as its texture rect's, moved by its transform like window.draw would
+    const sf::Transform& transform = tile.getTransform();
+    sf::Vector2f size = tile.getSize();
+    sf::Vector2f corners[4] = {
+        transform.transformPoint(0.f, 0.f), transform.transformPoint(size.x, 0.f),
+        transform.transformPoint(size.x, size.y), transform.transformPoint(0.f, size.y)
+    };
+    sf::Vector2f min = corners[0];
+    sf::Vector2f max = corners[0];
+    for (int i = 1; i < 4; ++i) {
+        min.x = std::min(min.x, corners[i].x);
+        min.y = std::min(min.y, corners[i].y);
+        max.x = std::max(max.x, corners[i].x);
+        max.y = std::max(max.y, corners[i].y);
+    }
+    sf::FloatRect bounds(min, max - min);
+
+    int cellX = (int)std::floor((min.x + max.x) / 2.f / chunkSize);
+    int cellY = (int)std::floor((min.y + max.y) / 2.f / chunkSize);
+    long long key = (long long)(((unsigned long long)(unsigned int)cellX << 32) | (unsigned int)cellY);
+    auto it = chunkIndex.find(key);
+    if (it == chunkIndex.end()) {
+        it = chunkIndex.emplace(key, (int)chunks.size()).first;
+        chunks.push_back({ sf::FloatRect(), 0, {} });
+    }
+    Chunk& chunk = chunks[it->second];
+    if (chunk.tileCount == 0) {
+        chunk.bounds = bounds;
+    }
+    else {
+        float left = std::min(chunk.bounds.left, bounds.left);
+        float top = std::min(chunk.bounds.top, bounds.top);
+        float right = std::max(chunk.bounds.left + chunk.bounds.width, bounds.left + bounds.width);
+        float bottom = std::max(chunk.bounds.top + chunk.bounds.height, bounds.top + bounds.height);
+        chunk.bounds = sf::FloatRect(left, top, right - left, bottom - top);
+    }
+    ++chunk.tileCount;
+
+    // A level only uses a few textures, so a chunk's groups are searched in order
+    Group* group = nullptr;
+    for (auto& g : chunk.groups) {
+        if (g.texture == texture) {
+            group = &g;
+            break;
+        }
+    }
+    if (!group) {
+        chunk.groups.push_back({ texture, sf::VertexArray(sf::Quads) });
+        group = &chunk.groups.back();
+    }
+
+    sf::FloatRect rect(tile.getTextureRect());
+    sf::Color colour = tile.getFillColor();
+    group->vertices.append(sf::Vertex(corners[0], colour, sf::Vector2f(rect.left, rect.top)));
+    group->vertices.append(sf::Vertex(corners[1], colour, sf::Vector2f(rect.left + rect.width, rect.top)));
+    group->vertices.append(sf::Vertex(corners[2], colour, sf::Vector2f(rect.left + rect.width, rect.top + rect.height)));
+    group->vertices.append(sf::Vertex(corners[3], colour, sf::Vector2f(rect.left, rect.top + rect.height)));
+    ++tileCount;
+}
+
+int TileBatch::getChunkCount() const
+{
+    int count = 0;
+    for (auto& chunk : chunks) {
+        if (chunk.tileCount > 0) ++count;
+    }
+    return count;
+}
+
+sf::FloatRect TileBatch::getViewBounds(const sf::View& view)
+{
+    // The view's inverse transform takes the corners of the screen back into the world
+    return view.getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+}
+
+void TileBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    sf::FloatRect viewBounds = getViewBounds(target.getView());
+    drawCalls = 0;
+    visibleTiles = 0;
+    visibleChunks = 0;
+    for (auto& chunk : chunks) {
+        if (chunk.tileCount == 0 || !chunk.bounds.intersects(viewBounds)) continue;
+        ++visibleChunks;
+        visibleTiles += chunk.tileCount;
+        for (auto& group : chunk.groups) {
+            if (group.vertices.getVertexCount() == 0) continue;
+            states.texture = group.texture;
+            target.draw(group.vertices, states);
+            ++drawCalls;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// Tile Batch Class
+// Draws a set of tiles with a handful of draw calls. The level is split into square chunks, and within a chunk tiles are grouped by
+// texture into a single sf::VertexArray of quads built from the tiles' transforms, texture rects and fill colours, in the order they were added.
+// Only the chunks inside the target's view are drawn, so the cost follows what is on screen rather than the size of the level.
+// The arrays are kept between frames, so they only need rebuilding when a tile moves, resizes or changes texture.
+
+#pragma once
+#include "SFML\Graphics.hpp"
+#include <vector>
+#include <unordered_map>
+
+class TileBatch : public sf::Drawable
+{
+public:
+	// Chunk size in world units, call before adding tiles. Smaller chunks cull more tightly for more draw calls
+	void setChunkSize(float size) { chunkSize = size; }
+
+	// Empties every chunk, keeping the memory for the next build
+	void clear();
+	// Adds a tile's quad to the chunk its centre is in. Shapes without a texture are skipped
+	void add(const sf::RectangleShape& tile);
+
+	int getTileCount() const { return tileCount; }
+	int getChunkCount() const;
+	// What the last draw did: one draw call per texture in each chunk in view
+	int getDrawCalls() const { return drawCalls; }
+	int getVisibleTileCount() const { return visibleTiles; }
+	int getVisibleChunkCount() const { return visibleChunks; }
+
+	// Area of the world a view shows, zoom and rotation included
+	static sf::FloatRect getViewBounds(const sf::View& view);
+
+private:
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+	struct Group
+	{
+		const sf::Texture* texture;
+		sf::VertexArray vertices;
+	};
+	struct Chunk
+	{
+		sf::FloatRect bounds;	// around every tile in the chunk, tiles can reach past its square
+		int tileCount;
+		std::vector<Group> groups;
+	};
+	std::vector<Chunk> chunks;
+	std::unordered_map<long long, int> chunkIndex;	// chunk square packed into 64 bits, to its chunk
+	float chunkSize = 1024.f;
+	int tileCount = 0;
+
+	mutable int drawCalls = 0;
+	mutable int visibleTiles = 0;
+	mutable int visibleChunks = 0;
+};
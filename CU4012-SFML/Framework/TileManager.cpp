@@ -22,14 +22,15 @@ void TileManager::handleInput(float dt)
         bool tileClicked = false;
         int clickedTileIndex = -1;
 
-        // Check if any tile is clicked
-        for (int i = 0; i < tiles.size(); ++i) {
-            if (Collision::checkBoundingBox(tiles[i]->getCollisionBox(), sf::Vector2i(worldPos))) {
-                tileClicked = true;
-                clickedTileIndex = i;
-                break;
+        // Ask the world which tiles are under the mouse. The first tile in the list wins when tiles overlap
+        world->queryPoint(sf::Vector2f(sf::Vector2i(worldPos)), [&](GameObject* obj) {
+            int index = findTileIndex(obj);
+            if (index != -1 && (clickedTileIndex == -1 || index < clickedTileIndex)) {
+                clickedTileIndex = index;
             }
-        }
+            return true;
+        });
+        tileClicked = clickedTileIndex != -1;
 
         if (tileClicked) {
             if (input->isKeyDown(sf::Keyboard::LControl) || input->isKeyDown(sf::Keyboard::RControl)) {
@@ -71,6 +72,7 @@ void TileManager::handleInput(float dt)
                     newTile->setPosition(worldPos.x, worldPos.y);
                     world->AddGameObject(*newTile);
                     tiles.push_back(std::move(newTile));
+                    markTilesChanged();
                     int newIndex = tiles.size() - 1; // Get the index of the newly added tile
                     selectedTileIndices.insert(newIndex); // Select the newly added tile
                     tiles[newIndex]->setEditing(true);
@@ -95,12 +97,21 @@ void TileManager::handleInput(float dt)
         tiles[index]->handleInput(dt);
     }
 
+    // Selected tiles can be moved with the arrow keys, the world has to re-index its static tiles when they do
+    if (!selectedTileIndices.empty() &&
+        (input->isKeyDown(sf::Keyboard::Left) || input->isKeyDown(sf::Keyboard::Right) ||
+         input->isKeyDown(sf::Keyboard::Up) || input->isKeyDown(sf::Keyboard::Down))) {
+        world->markStaticDirty();
+        markTilesMoved();
+    }
+
     // Update the color of the tiles based on selection and tag
+    const int wallTag = Tags::getId("Wall");
     for (int i = 0; i < tiles.size(); ++i) {
         if (selectedTileIndices.find(i) != selectedTileIndices.end()) {
             tiles[i]->setColor(sf::Color::Green); // Highlight selected tiles
         }
-        else if (tiles[i]->getTag() == "Wall") {
+        else if (tiles[i]->getTagId() == wallTag) {
             tiles[i]->setColor(sf::Color::Blue);
         }
         else {
@@ -121,10 +132,14 @@ void TileManager::handleInput(float dt)
                 duplicatedTile->setPosition(tile->getPosition());
                 duplicatedTile->setSize(tile->getSize());
                 duplicatedTile->setTag(tile->getTag());
-                duplicatedTile->setTexture(tile->getTexture()); // Ensure this method exists and works correctly
+                duplicatedTile->setTexture(tile->getTexture()); // Same atlas page and rect as the original
+                duplicatedTile->setTextureRect(tile->getTextureRect());
+                duplicatedTile->setTextureName(tile->getTextureName());
                 duplicatedTile->setTrigger(tile->getTrigger());
                 duplicatedTile->setStatic(tile->getStatic());
                 duplicatedTile->setMassless(tile->getMassless());
+                duplicatedTile->setCollisionLayer(tile->getCollisionLayer());
+                duplicatedTile->setCollisionMask(tile->getCollisionMask());
                 newTiles.push_back(std::move(duplicatedTile));
             }
 
@@ -133,6 +148,7 @@ void TileManager::handleInput(float dt)
                 world->AddGameObject(*newTile);
                 int newIndex = tiles.size();
                 tiles.push_back(std::move(newTile));
+                markTilesChanged();
                 selectedTileIndices.insert(newIndex); // Select new tiles
             }
 
@@ -142,17 +158,7 @@ void TileManager::handleInput(float dt)
 
     //Deletion
     if (input->isKeyDown(sf::Keyboard::Delete)) {
-        // Sort selected indices in descending order to safely delete multiple tiles without invalidating indices
-        std::vector<int> sortedIndices(selectedTileIndices.begin(), selectedTileIndices.end());
-        std::sort(sortedIndices.rbegin(), sortedIndices.rend()); // Reverse sort
-
-        for (int index : sortedIndices) {
-            if (index >= 0 && index < tiles.size()) {
-                world->RemoveGameObject(*tiles[index]);
-                tiles.erase(tiles.begin() + index);
-            }
-        }
-        selectedTileIndices.clear(); // Clear selection after deletion
+        deleteSelectedTiles(); // Also clears the selection
         input->setKeyUp(sf::Keyboard::Delete); // Prevent continuous deletion while the key is held down
     }
 }
@@ -166,25 +172,105 @@ void TileManager::update(float dt)
 }
 
 void TileManager::render(bool editMode) {
-    for (auto& tilePtr : tiles) {
-        if (tilePtr) { // Check if the pointer is not null
-            if (editMode) {
-                sf::RectangleShape rect = tilePtr->getDebugCollisionBox();
-                rect.setOutlineThickness(5);
-                int tileIndex = &tilePtr - &tiles[0]; // Get index of the tile
-
-                // Highlight selected tiles
-                if (selectedTileIndices.find(tileIndex) != selectedTileIndices.end()) {
-                    rect.setOutlineColor(sf::Color::Green);
-                } else {
-                    rect.setOutlineColor(sf::Color::Red);
-                }
-                
-                window->draw(rect);
+    // Only the tiles the world finds inside the window's current view are looked at, in list order so overlapping tiles draw the same way as before.
+    // The view's bounds take in the editor's zoom and any rotation
+    sf::FloatRect viewRect = TileBatch::getViewBounds(window->getView());
+    visibleTiles.clear();
+    world->queryAABB(viewRect, [this](GameObject* obj) {
+        int index = findTileIndex(obj);
+        if (index != -1) visibleTiles.push_back(index);
+        return true;
+    });
+    std::sort(visibleTiles.begin(), visibleTiles.end());
+
+    drawCalls = 0;
+    if (rendering == TileRendering::Batched) {
+        if (batchDirty) {
+            batch.clear();
+            for (auto& tilePtr : tiles) {
+                if (tilePtr->getStatic()) batch.add(*tilePtr);
+            }
+            batchDirty = false;
+        }
+        window->draw(batch);
+        drawCalls += batch.getDrawCalls();
+    }
+    else if (rendering == TileRendering::Cached) {
+        if (batchDirty) {
+            std::vector<const sf::RectangleShape*> staticTiles;
+            staticTiles.reserve(tiles.size());
+            for (auto& tilePtr : tiles) {
+                if (tilePtr->getStatic() && tilePtr->getTexture() != NULL) staticTiles.push_back(tilePtr.get());
             }
-            if(!tilePtr->getTexture()==NULL) window->draw(*tilePtr); // Draw the tile
+            chunkCache.update(staticTiles);
+            batchDirty = false;
+        }
+        chunkCache.draw(*window);
+        drawCalls += chunkCache.getDrawCalls();
+    }
+
+    for (int tileIndex : visibleTiles) {
+        auto& tilePtr = tiles[tileIndex];
+        if (editMode) {
+            sf::RectangleShape rect = tilePtr->getDebugCollisionBox();
+            rect.setOutlineThickness(5);
+
+            // Highlight selected tiles
+            if (selectedTileIndices.find(tileIndex) != selectedTileIndices.end()) {
+                rect.setOutlineColor(sf::Color::Green);
+            } else {
+                rect.setOutlineColor(sf::Color::Red);
+            }
+            
+            window->draw(rect);
+            ++drawCalls;
+        }
+        // Static tiles are in the batch or chunk cache. Other tiles can be moved by the world without the tile manager knowing, so they are drawn on their own
+        if (tilePtr->getTexture() != NULL && !(rendering != TileRendering::PerTile && tilePtr->getStatic())) {
+            window->draw(*tilePtr); // Draw the tile
+            ++drawCalls;
+        }
+    }
+}
+
+void TileManager::displayRenderStats()
+{
+    ImGui::Text("Tiles in view: %d / %d", (int)visibleTiles.size(), (int)tiles.size());
+    if (rendering == TileRendering::Batched) {
+        ImGui::Text("Batch chunks drawn: %d / %d", batch.getVisibleChunkCount(), batch.getChunkCount());
+    }
+    else if (rendering == TileRendering::Cached) {
+        ImGui::Text("Cached chunks drawn: %d / %d", chunkCache.getVisibleChunkCount(), chunkCache.getChunkCount());
+        ImGui::Text("Chunk textures: %d / %d, baked this frame: %d", chunkCache.getBakedCount(), chunkCache.getMaxChunks(), chunkCache.getBakeCount());
+    }
+    ImGui::Text("Tile draw calls: %d", drawCalls);
+    ImGui::Text("Frame time: %.2f ms", 1000.0f / ImGui::GetIO().Framerate);
+}
+
+void TileManager::DrawRenderStats()
+{
+    // Small see through window in the top right corner, out of the way of the game's own UI
+    ImGui::SetNextWindowPos(ImVec2((float)window->getSize().x - 10.f, 10.f), ImGuiCond_Always, ImVec2(1.f, 0.f));
+    ImGui::SetNextWindowBgAlpha(0.5f);
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+        ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+    if (ImGui::Begin("Render Stats", nullptr, flags)) {
+        displayRenderStats();
+    }
+    ImGui::End();
+}
+
+int TileManager::findTileIndex(const GameObject* obj)
+{
+    if (tileIndicesDirty) {
+        tileIndices.clear();
+        for (int i = 0; i < (int)tiles.size(); ++i) {
+            tileIndices[tiles[i].get()] = i;
         }
+        tileIndicesDirty = false;
     }
+    auto it = tileIndices.find(obj);
+    return it != tileIndices.end() ? it->second : -1;
 }
 
 
@@ -224,7 +310,9 @@ void TileManager::saveTiles(const std::vector<std::unique_ptr<Tiles>>& tiles, co
             << tile->getStatic() << ","
             << tile->getMassless() << ","
             << tile->getTile() << ","
-            << tile->getTextureName() << "\n";  // Ensure the texture name is always written, even if it's empty
+            << tile->getTextureName() << ","  // Ensure the texture name is always written, even if it's empty
+            << tile->getCollisionLayer() << ","
+            << tile->getCollisionMask() << "\n";
     }
 }
 
@@ -259,14 +347,20 @@ bool TileManager::loadTiles()
             // Check if a texture name exists and is valid
             if (seglist.size() > 9 && !seglist[9].empty()) {
                 newTile->setTextureName(seglist[9]);
-                sf::Texture* texture = textureManager.getTexture(seglist[9]);
-                if (texture) {
-                    newTile->setTexture(texture);
-                }
+                textureManager.applyTexture(*newTile, seglist[9]);
+            }
+
+            // Collision layer and mask bits, older files without them use the layer matching the tag
+            if (seglist.size() > 10 && !seglist[10].empty()) {
+                newTile->setCollisionLayer(std::stoul(seglist[10]));
+            }
+            if (seglist.size() > 11 && !seglist[11].empty()) {
+                newTile->setCollisionMask(std::stoul(seglist[11]));
             }
 
             world->AddGameObject(*newTile);
             tiles.push_back(std::move(newTile));
+            markTilesChanged();
         }
     }
 
@@ -280,18 +374,53 @@ std::vector<std::unique_ptr<Tiles>>& TileManager::getTiles() {
 
 void TileManager::RemoveCollectable()
 {
-    auto newEnd = std::remove_if(tiles.begin(), tiles.end(),
-        [this](const std::unique_ptr<Tiles>& tilePtr) -> bool
-        {
-            if (tilePtr->CollisionWithTag("Player") && tilePtr->getTag()== "Collectable")
-            {
-                world->RemoveGameObject(*tilePtr);
-                return true; // Mark for removal
+    // Collectables are marked as not alive when they are picked up
+    const int collectableTag = Tags::getId("Collectable");
+    std::vector<bool> removed(tiles.size(), false);
+    bool any = false;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (!tiles[i]->isAlive() && tiles[i]->getTagId() == collectableTag) {
+            removed[i] = true;
+            any = true;
+        }
+    }
+
+    if (any) {
+        removeTiles(removed);
+    }
+}
+
+void TileManager::removeTiles(const std::vector<bool>& removed)
+{
+    // Take them out of the world first, while they still exist. Handles to them go stale
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (removed[i]) {
+            world->RemoveGameObject(*tiles[i]);
+        }
+    }
+
+    // Compact the list, remembering where each kept tile went so the selection still points at the same tiles
+    std::vector<int> newIndex(tiles.size(), -1);
+    size_t kept = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (!removed[i]) {
+            newIndex[i] = (int)kept;
+            if (kept != i) {
+                tiles[kept] = std::move(tiles[i]);
             }
-            return false; // Keep in the vector
-        });
+            ++kept;
+        }
+    }
+    tiles.resize(kept);
+    markTilesChanged();
 
-    tiles.erase(newEnd, tiles.end());
+    std::set<int> selection;
+    for (int index : selectedTileIndices) {
+        if (index >= 0 && index < (int)newIndex.size() && newIndex[index] != -1) {
+            selection.insert(newIndex[index]);
+        }
+    }
+    selectedTileIndices.swap(selection);
 }
 
 void TileManager::DrawImGui() {
@@ -323,6 +452,26 @@ void TileManager::DrawImGui() {
             ImGui::Text("Tab: Save and Exit");
         }
 
+        if (ImGui::CollapsingHeader("Rendering"))
+        {
+            int mode = (int)rendering;
+            ImGui::RadioButton("Per tile", &mode, (int)TileRendering::PerTile);
+            ImGui::SameLine();
+            ImGui::RadioButton("Batched", &mode, (int)TileRendering::Batched);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Draw static tiles with one draw call per texture instead of one per tile.");
+            }
+            ImGui::SameLine();
+            ImGui::RadioButton("Cached chunks", &mode, (int)TileRendering::Cached);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Bake static tiles into a texture per chunk of the world the first time it is seen, and draw one quad per chunk.");
+            }
+            if (mode != (int)rendering) {
+                setRendering((TileRendering)mode);
+            }
+            displayRenderStats();
+        }
+
         if (ImGui::CollapsingHeader("Best Checkbox Combinations"))
         {
             if (ImGui::CollapsingHeader("Checkpoint:"))
@@ -391,6 +540,8 @@ void TileManager::DrawImGui() {
                             tile.setStatic(false);
                             tile.setTag("Collectable");
                         }
+                        world->markStaticDirty();
+                        markTilesMoved();
                     }
                     ImGui::SameLine();
                     if (ImGui::IsItemHovered()) {
@@ -406,6 +557,8 @@ void TileManager::DrawImGui() {
                             tile.setMassless(false);
                             tile.setTag("Platform");
                         }
+                        world->markStaticDirty();
+                        markTilesMoved();
                     }
                     ImGui::SameLine();
                     if (ImGui::IsItemHovered()) {
@@ -421,6 +574,8 @@ void TileManager::DrawImGui() {
                             tile.setMassless(false);
                             tile.setTag("Checkpoint");
                         }
+                        world->markStaticDirty();
+                        markTilesMoved();
                     }
                     ImGui::SameLine();
                     if (ImGui::IsItemHovered()) {
@@ -497,12 +652,12 @@ void TileManager::displayTextureSelection(TextureManager& textureManager) {
                 // Set the new current item
                 current_item = n;
                 // Update the texture on all selected tiles
-                sf::Texture* selectedTexture = textureManager.getTexture(textureNames[n]);
                 for (auto idx : selectedTileIndices) 
                 {
-                    tiles[idx]->setTexture(selectedTexture,true);
+                    textureManager.applyTexture(*tiles[idx], textureNames[n]);
                     tiles[idx]->setTextureName(textureNames[n]);  // Save the texture name
                 }
+                markTilesMoved();
                 
             }
             if (is_selected) {
@@ -533,6 +688,8 @@ void TileManager::displayTilePositions() {
             sf::Vector2f currentPos = tiles[idx]->getPosition();
             tiles[idx]->setPosition(currentPos + deltaPos);
         }
+        world->markStaticDirty();
+        markTilesMoved();
     }
     if (ImGui::IsItemHovered())
     {
@@ -558,6 +715,8 @@ void TileManager::displayTileScales() {
             sf::Vector2f currentScale = tiles[idx]->getSize();
             tiles[idx]->setSize(currentScale + deltaScale);
         }
+        world->markStaticDirty();
+        markTilesMoved();
     }
     if (ImGui::IsItemHovered())
     {
@@ -606,9 +765,9 @@ void TileManager::displayTileProperties(Tiles& tile)
 
 bool TileManager::allTilesHaveSameTag() {
     if (selectedTileIndices.size() < 2) return true;
-    std::string firstTag = tiles[*selectedTileIndices.begin()]->getTag();
+    int firstTag = tiles[*selectedTileIndices.begin()]->getTagId();
     for (auto idx : selectedTileIndices) {
-        if (tiles[idx]->getTag() != firstTag) return false;
+        if (tiles[idx]->getTagId() != firstTag) return false;
     }
     return true;
 }
@@ -630,6 +789,8 @@ void TileManager::displayCheckBox(const char* label, bool& value) {
                 tiles[idx]->setTile(currentValue);
             }
         }
+        world->markStaticDirty();
+        markTilesMoved();
     }
     if (ImGui::IsItemHovered()) {
         if (strcmp(label, "Trigger") == 0) {
@@ -652,17 +813,19 @@ void TileManager::addNewTile() {
     newTile->setPosition(0, 0);  // Default position
     world->AddGameObject(*newTile);
     tiles.push_back(std::move(newTile));
+    markTilesChanged();
     selectedTileIndices.clear();
     selectedTileIndices.insert(tiles.size() - 1);
 }
 
 void TileManager::deleteSelectedTiles() {
-    std::vector<int> sortedIndices(selectedTileIndices.begin(), selectedTileIndices.end());
-    std::sort(sortedIndices.rbegin(), sortedIndices.rend());
-    for (int idx : sortedIndices) {
-        world->RemoveGameObject(*tiles[idx]);
-        tiles.erase(tiles.begin() + idx);
+    std::vector<bool> removed(tiles.size(), false);
+    for (int idx : selectedTileIndices) {
+        if (idx >= 0 && idx < (int)tiles.size()) {
+            removed[idx] = true;
+        }
     }
+    removeTiles(removed);
     selectedTileIndices.clear();
 }
 
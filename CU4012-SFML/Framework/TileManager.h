@@ -3,12 +3,18 @@
 #include "World.h"
 #include "Tiles.h"
 #include "TextureManager.h"
+#include "TileBatch.h"
+#include "ChunkCache.h"
+#include <unordered_map>
 #include <fstream>
 #include <vector>
 #include <string>
 #include <sstream> // This is required for std::stringstream
 #include <set>     // For selecting multiple tiles
 
+// How static tiles are drawn: each on its own, batched into vertex arrays, or baked into cached chunk textures
+enum class TileRendering { PerTile, Batched, Cached };
+
 class TileManager : public GameObject
 {
     std::set<int> selectedTileIndices; // Set to keep track of selected tile indices
@@ -20,6 +26,17 @@ class TileManager : public GameObject
     std::vector<std::unique_ptr<Tiles>> tiles;
     
     TextureManager textureManager;
+    // Index of each tile in the tiles list, so objects found by world queries can be matched to their tile
+    std::unordered_map<const GameObject*, int> tileIndices;
+    bool tileIndicesDirty = true;
+    std::vector<int> visibleTiles;
+    // Static textured tiles drawn with one draw call per texture, rebuilt when tiles change
+    TileBatch batch;
+    // Static tiles baked into render textures a chunk at a time, only the chunks with changed tiles are baked again
+    ChunkCache chunkCache;
+    TileRendering rendering = TileRendering::Cached;
+    bool batchDirty = true;
+    int drawCalls = 0;
 
     std::string filePath; // File to store tile data
 
@@ -69,4 +86,27 @@ public:
     void displayCheckBox(const char* label, bool& value);
     void addNewTile();
     void deleteSelectedTiles();
+    // Removes the flagged tiles from the world and the list in a single pass, the selection moves with the tiles that are left
+    void removeTiles(const std::vector<bool>& removed);
+
+    // Call whenever tiles are added to, removed from or reordered in the tiles list
+    void markTilesChanged() { tileIndicesDirty = true; batchDirty = true; }
+    // Call whenever tiles move, resize, change texture or stop or start being static, so the batch or chunk cache is brought up to date
+    void markTilesMoved() { batchDirty = true; }
+
+    // Batched drawing puts every static tile in one vertex array per texture. Cached drawing bakes them into a texture per chunk of
+    // the world, so a frame only draws one quad per chunk. Per tile draws each visible tile on its own, to compare
+    void setRendering(TileRendering r) { rendering = r; batchDirty = true; }
+    TileRendering getRendering() const { return rendering; }
+    ChunkCache& getChunkCache() { return chunkCache; }
+    // Draw calls made by the last render, editor outlines included
+    int getDrawCalls() const { return drawCalls; }
+    // Tiles the last render found in the view, out of all the tiles
+    int getVisibleTileCount() const { return (int)visibleTiles.size(); }
+    int getTileCount() const { return (int)tiles.size(); }
+    // Overlay with the visible and total tile counts and draw calls from the last render
+    void DrawRenderStats();
+    void displayRenderStats();
+    // Index in the tiles list of a tile found by a world query, -1 if the object is not one of our tiles
+    int findTileIndex(const GameObject* obj);
 };
\ No newline at end of file
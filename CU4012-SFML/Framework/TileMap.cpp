@@ -1,22 +1,53 @@
 #include "TileMap.h"
+#include "TileBatch.h"
 
 // Constructor sets default position value.
 TileMap::TileMap()
 {
 	position = sf::Vector2f(0, 0);
+	vertices.setPrimitiveType(sf::Quads);
 }
 
 TileMap::~TileMap()
 {
 }
 
-// Uses window pointer to render level/section. Tile by Tile.
+// Uses window pointer to render level/section. Only the cells in the window's view, in one draw call.
 void TileMap::render(sf::RenderWindow* window)
 {
-	for (int i = 0; i < (int)level.size(); i++)
+	if (mapSize.x == 0 || mapSize.y == 0 || tileRects.empty() || tileSize.x <= 0.f || tileSize.y <= 0.f)
 	{
-		window->draw(level[i]);
+		return;
 	}
+
+	// Rows and columns under the view, clamped to the map
+	sf::FloatRect view = TileBatch::getViewBounds(window->getView());
+	int x0 = std::max((int)floor((view.left - position.x) / tileSize.x), 0);
+	int y0 = std::max((int)floor((view.top - position.y) / tileSize.y), 0);
+	int x1 = std::min((int)floor((view.left + view.width - position.x) / tileSize.x), (int)mapSize.x - 1);
+	int y1 = std::min((int)floor((view.top + view.height - position.y) / tileSize.y), (int)mapSize.y - 1);
+	if (x0 > x1 || y0 > y1)
+	{
+		return;
+	}
+
+	// The quads are only refilled when the view moves onto other cells
+	sf::IntRect cells(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+	if (cells != drawnCells)
+	{
+		drawnCells = cells;
+		vertices.resize((size_t)cells.width * cells.height * 4);
+		sf::Vertex* quad = &vertices[0];
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++, quad += 4)
+			{
+				writeCell(x, y, quad);
+			}
+		}
+	}
+
+	window->draw(vertices, &texture);
 }
 
 // Loads and stores the spritesheet containing all the tiles required to build the level/section
@@ -29,6 +60,18 @@ void TileMap::loadTexture(const char* filename)
 void TileMap::setTileSet(std::vector<GameObject> ts)
 {
 	tileSet = ts;
+	textureTileSize = sf::Vector2u(0, 0);
+	if (tileSet.size() > 0)
+	{
+		tileSize = tileSet[0].getSize();
+	}
+}
+
+// Tiles are cut from the spritesheet in a grid when the level is built
+void TileMap::setTileLayout(sf::Vector2u texTileSize, sf::Vector2f size)
+{
+	textureTileSize = texTileSize;
+	tileSize = size;
 }
 
 // Receives and array of integers and map dimensions representing the map (where and what tiles to place).
@@ -36,23 +79,84 @@ void TileMap::setTileMap(std::vector<int> tm, sf::Vector2u mapDimensions)
 {
 	tileMap = tm;
 	mapSize = mapDimensions;
+	tileMap.resize((size_t)mapSize.x * mapSize.y, -1);
+	drawnCells = sf::IntRect();
 }
 
-// Once provided with the map and tile set, builds the level, creating an array of tile sprites positioned based on the map. Ready to render.
+// Once provided with the map and tile set, works out where each tile is in the texture. The cells themselves stay as indices.
 void TileMap::buildLevel()
 {
-	if (tileSet.size() > 0 && tileMap.size() > 0)
+	tileRects.clear();
+	tileColours.clear();
+
+	if (textureTileSize.x > 0 && textureTileSize.y > 0)
+	{
+		// Every whole tile in the sheet, in reading order
+		unsigned int columns = texture.getSize().x / textureTileSize.x;
+		unsigned int rows = texture.getSize().y / textureTileSize.y;
+		for (unsigned int i = 0; i < columns * rows; i++)
+		{
+			tileRects.push_back(sf::IntRect((i % columns) * textureTileSize.x, (i / columns) * textureTileSize.y, textureTileSize.x, textureTileSize.y));
+			tileColours.push_back(sf::Color::White);
+		}
+	}
+	else if (tileSet.size() > 0)
 	{
-		int x, y = 0;
-		sf::Vector2f tileSize(tileSet[0].getSize().x, tileSet[0].getSize().y);
+		for (int i = 0; i < (int)tileSet.size(); i++)
+		{
+			tileRects.push_back(tileSet[i].getTextureRect());
+			tileColours.push_back(tileSet[i].getFillColor());
+		}
+	}
+
+	drawnCells = sf::IntRect();
+}
+
+void TileMap::setTile(int x, int y, int tile)
+{
+	if (x < 0 || y < 0 || x >= (int)mapSize.x || y >= (int)mapSize.y)
+	{
+		return;
+	}
+	tileMap[(size_t)y * mapSize.x + x] = tile;
+
+	// Cells in the vertex array get their quad rewritten, others are picked up when the view reaches them
+	if (drawnCells.contains(x, y))
+	{
+		size_t index = (size_t)(y - drawnCells.top) * drawnCells.width + (x - drawnCells.left);
+		writeCell(x, y, &vertices[index * 4]);
+	}
+}
+
+int TileMap::getTile(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= (int)mapSize.x || y >= (int)mapSize.y)
+	{
+		return -1;
+	}
+	return tileMap[(size_t)y * mapSize.x + x];
+}
 
-		for (int i = 0; i < (int)tileMap.size(); i++)
+void TileMap::writeCell(int x, int y, sf::Vertex* quad) const
+{
+	int tile = tileMap[(size_t)y * mapSize.x + x];
+	sf::Vector2f topLeft(position.x + x * tileSize.x, position.y + y * tileSize.y);
+	if (tile < 0 || tile >= (int)tileRects.size())
+	{
+		for (int i = 0; i < 4; i++)
 		{
-			x = i % mapSize.x;
-			y = (int)floor(i / mapSize.x);
-			tileSet[tileMap[i]].setPosition(position.x + (x * tileSize.x), position.y + (y * tileSize.y));
-			level.push_back(tileSet[tileMap[i]]);
-			level[i].setTexture(&texture);
+			quad[i] = sf::Vertex(topLeft, sf::Color::Transparent);
 		}
+		return;
 	}
-}
\ No newline at end of file
+
+	const sf::IntRect& rect = tileRects[tile];
+	float left = (float)rect.left;
+	float top = (float)rect.top;
+	float right = (float)(rect.left + rect.width);
+	float bottom = (float)(rect.top + rect.height);
+	quad[0] = sf::Vertex(topLeft, tileColours[tile], sf::Vector2f(left, top));
+	quad[1] = sf::Vertex(sf::Vector2f(topLeft.x + tileSize.x, topLeft.y), tileColours[tile], sf::Vector2f(right, top));
+	quad[2] = sf::Vertex(topLeft + tileSize, tileColours[tile], sf::Vector2f(right, bottom));
+	quad[3] = sf::Vertex(sf::Vector2f(topLeft.x, topLeft.y + tileSize.y), tileColours[tile], sf::Vector2f(left, bottom));
+}
@@ -1,6 +1,8 @@
 // Tile Map Class
 // This class represents a Tile Map environment for rendering.
-// Builds and store level sections based on Map and TileSet
+// Stores the level as one tile index per cell and draws it from a tile set texture. Only the cells under the view are put in a single
+// vertex array, drawn with one draw call, and the array is only refilled when the view moves onto other cells. Changing a cell
+// rewrites just that cell's quad.
 
 #pragma once
 #include <math.h>
@@ -14,27 +16,52 @@ public:
 
 	// Loads and stores the spritesheet containing all the tiles required to build the level/section
 	void loadTexture(const char* filename);
-	// Receives an array of GameObjects representing the tile set (in order)
+	// Receives an array of GameObjects representing the tile set (in order). Each tile's texture rect and fill colour are used,
+	// and the first tile's size is the size of every cell
 	void setTileSet(std::vector<GameObject> ts);
+	// Alternative to setTileSet for a spritesheet laid out as a grid: tile n is the nth textureTileSize cell of the sheet, reading
+	// left to right then top to bottom, drawn at tileSize
+	void setTileLayout(sf::Vector2u textureTileSize, sf::Vector2f tileSize);
 	// Receives and array of integers and map dimensions representing the map (where and what tiles to place).
 	void setTileMap(std::vector<int> tm, sf::Vector2u mapDimensions);
-	// Once provided with the map and tile set, builds the level, creating an array of tile sprites positioned based on the map. Ready to render.
+	// Once provided with the map and tile set, builds the level, working out the texture rect of every tile in the set. Ready to render.
 	void buildLevel();
 
-	// Receives window handle and renders the level/tilemap
+	// Receives window handle and renders the cells of the level/tilemap in its view
 	void render(sf::RenderWindow* window);
-	// Returns the built level tile map. Used for collision detection, etc, where we need access to elements of the level.
-	std::vector<GameObject>* getLevel(){ return &level; };
+
+	// Changes one cell, -1 (or any index outside the tile set) leaves it empty
+	void setTile(int x, int y, int tile);
+	int getTile(int x, int y) const;
 
 	// Set the origin position of the tilemap section. 
-	void setPosition(sf::Vector2f pos) { position = pos; };
+	void setPosition(sf::Vector2f pos) { position = pos; drawnCells = sf::IntRect(); };
+	sf::Vector2f getPosition() const { return position; }
+
+	// The map as given to setTileSet and setTileMap, used to build a CollisionGrid
+	const std::vector<GameObject>& getTileSet() const { return tileSet; }
+	const std::vector<int>& getTileMap() const { return tileMap; }
+	sf::Vector2u getMapSize() const { return mapSize; }
+	sf::Vector2f getTileSize() const { return tileSize; }
+	// Number of tiles in the tile set, valid tile indices are below this
+	int getTileCount() const { return (int)tileRects.size(); }
 
 protected:
+	// Fills the four vertices of a cell's quad, an empty cell gets a quad with no area
+	void writeCell(int x, int y, sf::Vertex* quad) const;
+
 	std::vector<GameObject> tileSet;
 	std::vector<int> tileMap;
-	std::vector<GameObject> level;
+	// Texture rect and colour of each tile in the set
+	std::vector<sf::IntRect> tileRects;
+	std::vector<sf::Color> tileColours;
 	sf::Texture texture;
+	sf::Vector2u textureTileSize;
+	sf::Vector2f tileSize;
 	sf::Vector2u mapSize;
 	sf::Vector2f position;
-};
 
+	// Quads for the cells in drawnCells, row by row
+	sf::VertexArray vertices;
+	sf::IntRect drawnCells;
+};
@@ -1,45 +1,1146 @@
-
 #include "World.h"
+#include "Collision.h"
+#include "Narrowphase.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstring>
 
 World::World()
 {
+    nextId = 0;
+    fixedStep = 1.f / 60.f;
+    maxSubSteps = 8;
+    accumulator = 0.f;
+    alpha = 1.f;
+    stepCount = 0;
+    deterministic = false;
+    bodyOrderDirty = false;
+    sleepingDirty = false;
+    sleepEnabled = true;
+    sleepSpeed = 5.f;
+    timeToSleep = 0.5f;
+    bulletThreshold = 0.5f;
+    collisionGrid = nullptr;
+    staticDirty = false;
+    locked = false;
+    broadphase = Broadphase::AABBTree;
+    solver.setBodyStore(&bodies);
+}
+
+void World::setCellSize(float size)
+{
+    staticHash.setCellSize(size);
+    dynamicHash.setCellSize(size);
+    staticDirty = true;
+}
+
+void World::setStepRate(float hz)
+{
+    if (hz > 0.f) {
+        fixedStep = 1.f / hz;
+    }
+}
+
+void World::setBroadphase(Broadphase b)
+{
+    if (b == broadphase) return;
+
+    // Sweep and prune proxies only exist while it is the broadphase in use, the tree is kept for queries whatever the broadphase
+    for (auto& obj : objects) {
+        obj->proxyId = -1;
+    }
+    sweepAndPrune.clear();
+    proxyBodies.clear();
+    staticPairs.clear();
+
+    broadphase = b;
+    if (broadphase == Broadphase::SweepAndPrune) {
+        for (auto& obj : objects) {
+            createProxy(obj);
+        }
+    }
+    addedPairs.clear();
+    removedPairs.clear();
+}
+
+void World::createProxy(GameObject* obj)
+{
+    if (broadphase == Broadphase::SweepAndPrune && !obj->getStatic()) {
+        obj->proxyId = sweepAndPrune.createProxy(obj->getCollisionBox());
+        if (obj->proxyId >= (int)proxyBodies.size()) {
+            proxyBodies.resize(obj->proxyId + 1, nullptr);
+        }
+        proxyBodies[obj->proxyId] = obj;
+    }
+}
+
+void World::destroyProxy(GameObject* obj)
+{
+    if (obj->treeProxyId >= 0) {
+        tree.destroyProxy(obj->treeProxyId);
+        obj->treeProxyId = -1;
+    }
+    if (obj->proxyId >= 0) {
+        sweepAndPrune.destroyProxy(obj->proxyId);
+        proxyBodies[obj->proxyId] = nullptr;
+        obj->proxyId = -1;
+    }
 }
 
-void World::AddGameObject(GameObject& obj)
+BodyHandle World::AddGameObject(GameObject& obj)
 {
-    objects.push_back(&obj);
+    if (objects.contains(obj.worldHandle)) {
+        // Added back before a queued removal was applied, keep it in the world
+        if (obj.removalQueued) {
+            obj.removalQueued = false;
+            removeFromList(pendingRemovals, &obj);
+        }
+        return obj.worldHandle;
+    }
+
+    obj.worldId = nextId++;
+    obj.world = this;
+    obj.sleeping = false;
+    obj.previousPosition = obj.getPosition();
+    obj.worldHandle = objects.insert(&obj);
+    // The proxies are made from the box, bring it to where the object is so it can be hit and picked straight away
+    obj.updateCollisionBox(0.f);
+
+    if (obj.getStatic()) {
+        obj.bodyIndex = (int)staticBodies.size();
+        staticBodies.push_back(&obj);
+        // Added to the built index as it is, a rebuild already due will pick it up anyway
+        if (!staticDirty) {
+            staticHash.add(obj.bodyIndex, obj.collisionBox);
+            staticBoxes.add(obj.collisionBox);
+        }
+    }
+    else {
+        obj.bodyIndex = (int)dynamicBodies.size();
+        dynamicBodies.push_back(&obj);
+        bodies.add(&obj);
+    }
+
+    obj.treeProxyId = tree.createProxy(obj.getCollisionBox(), &obj);
+    createProxy(&obj);
+    return obj.worldHandle;
 }
 
 void World::RemoveGameObject(GameObject& obj)
 {
-    objects.remove(&obj);
+    if (!objects.contains(obj.worldHandle) || obj.removalQueued) return;
+
+    obj.removalQueued = true;
+    pendingRemovals.push_back(&obj);
+
+    // During a step the lists are being iterated over, the removal waits until the step is done
+    if (!locked) {
+        applyRemovals();
+    }
+}
+
+void World::RemoveGameObject(BodyHandle handle)
+{
+    if (GameObject* obj = getObject(handle)) {
+        RemoveGameObject(*obj);
+    }
+}
+
+GameObject* World::getObject(BodyHandle handle) const
+{
+    GameObject* const* obj = objects.get(handle);
+    return obj ? *obj : nullptr;
+}
+
+void World::removeNow(GameObject* obj)
+{
+    objects.remove(obj->worldHandle);
+    obj->worldHandle = BodyHandle();
+    obj->removalQueued = false;
+    destroyProxy(obj);
+
+    // Anything resting on it has lost its support, and a sleeping object takes its island with it
+    wakeObject(*obj);
+    contactManager.forEachContact(obj, [this, obj](const Contact& contact) {
+        wakeObject(*contact.getOther(obj));
+    });
+    obj->world = nullptr;
+    contactManager.removeObject(obj);
+
+    // Only static objects hit last step are in here, so it stays short
+    touchedStatics.erase(std::remove(touchedStatics.begin(), touchedStatics.end(), obj), touchedStatics.end());
+
+    if (obj->bodyIndex < (int)staticBodies.size() && staticBodies[obj->bodyIndex] == obj) {
+        removeStatic(obj);
+    }
+    else if (obj->sleeping) {
+        unlinkIsland(obj);
+        removeFromList(sleepingBodies, obj);
+        obj->sleeping = false;
+        sleepingDirty = true;
+    }
+    else {
+        removeFromList(dynamicBodies, obj);
+        bodies.remove(obj);
+        bodyOrderDirty = bodyOrderDirty || deterministic;
+    }
+    obj->bodyIndex = -1;
+}
+
+void World::removeStatic(GameObject* obj)
+{
+    // The static index refers to staticBodies positions, the last static takes the removed one's place there too
+    if (!staticDirty) {
+        int index = obj->bodyIndex;
+        GameObject* last = staticBodies.back();
+        staticHash.remove(index, obj->collisionBox);
+        if (last != obj) {
+            staticHash.remove(last->bodyIndex, last->collisionBox);
+            staticHash.add(index, last->collisionBox);
+        }
+        staticBoxes.remove(index);
+    }
+    removeFromList(staticBodies, obj);
+}
+
+void World::removeFromList(std::vector<GameObject*>& list, GameObject* obj)
+{
+    // Swap with the last object, order does not matter as pairs are sorted by creation order
+    int index = obj->bodyIndex;
+    if (index < 0 || index >= (int)list.size() || list[index] != obj) {
+        index = (int)(std::find(list.begin(), list.end(), obj) - list.begin());
+        if (index == (int)list.size()) return;
+    }
+    list[index] = list.back();
+    list[index]->bodyIndex = index;
+    list.pop_back();
+}
+
+void World::rebuildStaticIndex()
+{
+    // Static flags may have changed since the objects were added, so split them again
+    dynamicBodies.clear();
+    staticBodies.clear();
+    sleepingBodies.clear();
+    for (auto& obj : objects) {
+        if (obj->getStatic()) {
+            // Made static while asleep, it no longer belongs to an island
+            if (obj->sleeping) {
+                unlinkIsland(obj);
+                obj->sleeping = false;
+            }
+            obj->bodyIndex = (int)staticBodies.size();
+            staticBodies.push_back(obj);
+        }
+        else if (obj->sleeping) {
+            obj->bodyIndex = (int)sleepingBodies.size();
+            sleepingBodies.push_back(obj);
+        }
+        else {
+            obj->bodyIndex = (int)dynamicBodies.size();
+            dynamicBodies.push_back(obj);
+        }
+    }
+
+    if (deterministic) {
+        sortBodies(staticBodies);
+        sortBodies(dynamicBodies);
+        sortBodies(sleepingBodies);
+    }
+    sleepingDirty = true;
+
+    // Only moving objects have a body, a live body's state goes back to its object and comes straight out again
+    bodies.clear();
+    for (auto& obj : dynamicBodies) {
+        bodies.add(obj);
+    }
+
+    // Static objects are not stepped, sync their collision box with where they are before indexing.
+    // Only the box, their own update logic is left to the game
+    staticHash.clear();
+    staticBoxes.clear();
+    for (int i = 0; i < (int)staticBodies.size(); ++i) {
+        staticBodies[i]->updateCollisionBox(0.f);
+        staticHash.insert(i, staticBodies[i]->getCollisionBox());
+        staticBoxes.add(staticBodies[i]->getCollisionBox());
+        tree.moveProxy(staticBodies[i]->treeProxyId, staticBodies[i]->getCollisionBox(), sf::Vector2f(0.f, 0.f));
+    }
+
+    // Only dynamic objects are in the sweep and prune, objects that changed their static flag join or leave it
+    if (broadphase == Broadphase::SweepAndPrune) {
+        for (auto& obj : objects) {
+            if (obj->getStatic() && obj->proxyId >= 0) {
+                sweepAndPrune.destroyProxy(obj->proxyId);
+                proxyBodies[obj->proxyId] = nullptr;
+                obj->proxyId = -1;
+            }
+            else if (!obj->getStatic() && obj->proxyId < 0) {
+                createProxy(obj);
+            }
+        }
+    }
+    staticDirty = false;
+}
+
+void World::findPairs()
+{
+    pairs.clear();
+
+    switch (broadphase)
+    {
+    case Broadphase::BruteForce:
+        findPairsBruteForce();
+        break;
+    case Broadphase::SpatialHash:
+        findPairsSpatialHash();
+        break;
+    case Broadphase::SweepAndPrune:
+        findPairsSweepAndPrune();
+        break;
+    case Broadphase::AABBTree:
+        findPairsAABBTree();
+        break;
+    }
+
+    // Drop pairs whose collision layers do not collide, a single AND each way
+    pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [](const CollisionPair& pair) {
+        return !CollisionLayers::shouldCollide(pair.first->collisionLayer, pair.first->collisionMask,
+            pair.second->collisionLayer, pair.second->collisionMask);
+    }), pairs.end());
+
+    // Earlier created object first, in creation order, matching the order objects were added to the world
+    for (auto& pair : pairs) {
+        if (pair.firstId > pair.secondId) {
+            std::swap(pair.firstId, pair.secondId);
+            std::swap(pair.first, pair.second);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const CollisionPair& a, const CollisionPair& b) {
+        return a.firstId < b.firstId || (a.firstId == b.firstId && a.secondId < b.secondId);
+    });
+    pairs.erase(std::unique(pairs.begin(), pairs.end(), [](const CollisionPair& a, const CollisionPair& b) {
+        return a.firstId == b.firstId && a.secondId == b.secondId;
+    }), pairs.end());
+}
+
+void World::findPairsBruteForce()
+{
+    // Every dynamic object against every other object, with the SIMD box batches doing the overlap tests.
+    // Static objects never need testing against each other
+    dynamicBoxes.clear();
+    for (auto& obj : dynamicBodies) {
+        dynamicBoxes.add(obj->collisionBox);
+    }
+
+    for (int i = 0; i < (int)dynamicBodies.size(); ++i) {
+        GameObject* a = dynamicBodies[i];
+
+        batchHits.clear();
+        dynamicBoxes.query(a->collisionBox, batchHits);
+        for (int j : batchHits) {
+            if (j > i) {
+                pairs.push_back({ a->worldId, dynamicBodies[j]->worldId, a, dynamicBodies[j] });
+            }
+        }
+
+        batchHits.clear();
+        staticBoxes.query(a->collisionBox, batchHits);
+        for (int j : batchHits) {
+            pairs.push_back({ a->worldId, staticBodies[j]->worldId, a, staticBodies[j] });
+        }
+
+        batchHits.clear();
+        sleepingBoxes.query(a->collisionBox, batchHits);
+        for (int j : batchHits) {
+            pairs.push_back({ a->worldId, sleepingBodies[j]->worldId, a, sleepingBodies[j] });
+        }
+    }
+}
+
+void World::findPairsSpatialHash()
+{
+    // Dynamic against dynamic, using the hash rebuilt this step
+    dynamicHash.clear();
+    for (int i = 0; i < (int)dynamicBodies.size(); ++i) {
+        dynamicHash.insert(i, dynamicBodies[i]->getCollisionBox());
+    }
+    dynamicHash.getPairs(dynamicPairs);
+    for (auto& pair : dynamicPairs) {
+        GameObject* a = dynamicBodies[pair.first];
+        GameObject* b = dynamicBodies[pair.second];
+        pairs.push_back({ a->worldId, b->worldId, a, b });
+    }
+
+    // Dynamic against static, querying the prebuilt static index. Static objects never need testing against each other
+    for (auto& obj : dynamicBodies) {
+        staticCandidates.clear();
+        staticHash.query(obj->getCollisionBox(), staticCandidates);
+        for (int index : staticCandidates) {
+            pairs.push_back({ obj->worldId, staticBodies[index]->worldId, obj, staticBodies[index] });
+        }
+
+        // Sleeping objects are few and change often, so they are kept in a box batch rather than the hash
+        batchHits.clear();
+        sleepingBoxes.query(obj->getCollisionBox(), batchHits);
+        for (int index : batchHits) {
+            pairs.push_back({ obj->worldId, sleepingBodies[index]->worldId, obj, sleepingBodies[index] });
+        }
+    }
+}
+
+void World::findPairsSweepAndPrune()
+{
+    // Sleeping proxies keep their place, only awake objects move
+    for (auto& obj : dynamicBodies) {
+        sweepAndPrune.moveProxy(obj->proxyId, obj->getCollisionBox());
+    }
+    sweepAndPrune.update();
+
+    for (auto& pair : sweepAndPrune.getPairs()) {
+        GameObject* a = proxyBodies[pair.first];
+        GameObject* b = proxyBodies[pair.second];
+        if (!isAwakeBody(a) && !isAwakeBody(b)) continue;
+        pairs.push_back({ a->worldId, b->worldId, a, b });
+    }
+
+    // Awake objects against the static hash. Boxes are tested here, touching counting as overlapping as in the sweep and prune,
+    // so the overlaps can be compared with the last step's
+    previousStaticPairs.swap(staticPairs);
+    staticPairs.clear();
+    for (auto& obj : dynamicBodies) {
+        const sf::FloatRect& box = obj->collisionBox;
+        staticCandidates.clear();
+        staticHash.query(box, staticCandidates);
+        for (int index : staticCandidates) {
+            GameObject* other = staticBodies[index];
+            const sf::FloatRect& otherBox = other->collisionBox;
+            if (box.left > otherBox.left + otherBox.width || otherBox.left > box.left + box.width ||
+                box.top > otherBox.top + otherBox.height || otherBox.top > box.top + box.height) {
+                continue;
+            }
+            pairs.push_back({ obj->worldId, other->worldId, obj, other });
+            staticPairs.push_back({ obj->worldId, other->worldId, obj->worldHandle, other->worldHandle });
+        }
+    }
+    // Sleeping objects do not query, their overlaps carry on from when they fell asleep
+    for (auto& pair : previousStaticPairs) {
+        GameObject* obj = getObject(pair.first);
+        if (obj && obj->sleeping && getObject(pair.second)) {
+            staticPairs.push_back(pair);
+        }
+    }
+    auto pairLess = [](const StaticPair& a, const StaticPair& b) {
+        return a.firstId < b.firstId || (a.firstId == b.firstId && a.secondId < b.secondId);
+    };
+    std::sort(staticPairs.begin(), staticPairs.end(), pairLess);
+    staticPairs.erase(std::unique(staticPairs.begin(), staticPairs.end(), [](const StaticPair& a, const StaticPair& b) {
+        return a.firstId == b.firstId && a.secondId == b.secondId;
+    }), staticPairs.end());
+
+    // Report the overlap changes, pairs that lost an object have nothing left to report
+    addedPairs.clear();
+    removedPairs.clear();
+    for (auto& pair : sweepAndPrune.getAddedPairs()) {
+        addedPairs.push_back(std::make_pair(proxyBodies[pair.first], proxyBodies[pair.second]));
+    }
+    for (auto& pair : sweepAndPrune.getRemovedPairs()) {
+        GameObject* a = proxyBodies[pair.first];
+        GameObject* b = proxyBodies[pair.second];
+        if (a && b) removedPairs.push_back(std::make_pair(a, b));
+    }
+    size_t i = 0;
+    size_t j = 0;
+    while (i < staticPairs.size() || j < previousStaticPairs.size()) {
+        if (j == previousStaticPairs.size() || (i < staticPairs.size() && pairLess(staticPairs[i], previousStaticPairs[j]))) {
+            addedPairs.push_back(std::make_pair(getObject(staticPairs[i].first), getObject(staticPairs[i].second)));
+            ++i;
+        }
+        else if (i == staticPairs.size() || pairLess(previousStaticPairs[j], staticPairs[i])) {
+            GameObject* a = getObject(previousStaticPairs[j].first);
+            GameObject* b = getObject(previousStaticPairs[j].second);
+            if (a && b) removedPairs.push_back(std::make_pair(a, b));
+            ++j;
+        }
+        else {
+            ++i;
+            ++j;
+        }
+    }
+}
+
+void World::updateTree(float deltaTime)
+{
+    // Proxies are only reinserted when an object leaves its fat box, static proxies are moved when the static index is rebuilt
+    for (auto& obj : dynamicBodies) {
+        tree.moveProxy(obj->treeProxyId, obj->getCollisionBox(), obj->getVelocity() * deltaTime);
+    }
+}
+
+void World::findPairsAABBTree()
+{
+    // Each dynamic object queries the tree, pairs between two dynamic objects are found twice and removed by findPairs
+    for (auto& obj : dynamicBodies) {
+        GameObject* a = obj;
+        tree.query(a->getCollisionBox(), [this, a](int proxy) {
+            GameObject* b = static_cast<GameObject*>(tree.getUserData(proxy));
+            if (b != a) {
+                pairs.push_back({ a->worldId, b->worldId, a, b });
+            }
+            return true;
+        });
+    }
+}
+
+void World::sweepBullets()
+{
+    // Leaves the bullet this far inside what it hits, so the narrowphase still sees the contact and resolves it
+    const float skin = 0.01f;
+
+    for (auto& obj : dynamicBodies) {
+        if (!obj->isBullet) continue;
+
+        // Slow enough that the discrete test cannot miss anything
+        int body = obj->storeIndex;
+        sf::Vector2f displacement = bodies.getPosition(body) - bodies.getPreviousPosition(body);
+        sf::FloatRect end = obj->collisionBox;
+        if (std::abs(displacement.x) <= bulletThreshold * std::abs(end.width) &&
+            std::abs(displacement.y) <= bulletThreshold * std::abs(end.height)) {
+            continue;
+        }
+
+        sf::FloatRect start(end.left - displacement.x, end.top - displacement.y, end.width, end.height);
+        float left = std::min(start.left, end.left);
+        float top = std::min(start.top, end.top);
+        sf::FloatRect swept(left, top, std::max(start.left, end.left) + end.width - left, std::max(start.top, end.top) + end.height - top);
+
+        // Earliest hit wins, ties go to the earlier created object so the result does not depend on query order
+        float bestToi = 2.f;
+        sf::Vector2f bestNormal;
+        int bestId = -1;
+        auto test = [&](GameObject* other) {
+            if (other == obj || other->isTrigger || obj->isTrigger) return;
+            if (!CollisionLayers::shouldCollide(obj->collisionLayer, obj->collisionMask, other->collisionLayer, other->collisionMask)) return;
+
+            float toi;
+            sf::Vector2f normal;
+            if (Collision::sweepBoundingBox(start, displacement, other->collisionBox, toi, normal)) {
+                if (toi < bestToi || (toi == bestToi && other->worldId < bestId)) {
+                    bestToi = toi;
+                    bestNormal = normal;
+                    bestId = other->worldId;
+                }
+            }
+        };
+
+        // Every object's tree box holds its collision box, static and sleeping ones included, so the tree finds all it could hit
+        tree.query(swept, [&](int proxy) {
+            test(static_cast<GameObject*>(tree.getUserData(proxy)));
+            return true;
+        });
+
+        float gridToi;
+        sf::Vector2f gridNormal;
+        std::uint32_t gridLayer;
+        if (collisionGrid && !obj->isTrigger &&
+            collisionGrid->sweep(start, displacement, obj->collisionLayer, obj->collisionMask, gridToi, gridNormal, gridLayer) &&
+            gridToi < bestToi) {
+            bestToi = gridToi;
+            bestNormal = gridNormal;
+            bestId = getGridBody(gridLayer)->worldId;
+        }
+
+        if (bestId != -1) {
+            // Back up from the end of the move to the first contact
+            bodies.translate(body, displacement * (bestToi - 1.f) + bestNormal * skin);
+            tree.moveProxy(obj->treeProxyId, obj->collisionBox, sf::Vector2f(0.f, 0.f));
+        }
+    }
+}
+
+GameObject* World::getGridBody(std::uint32_t layer)
+{
+    int bit = 0;
+    while (bit < 31 && !(layer & (1u << bit))) {
+        ++bit;
+    }
+
+    if (!gridBodies[bit]) {
+        gridBodies[bit].reset(new GameObject());
+        GameObject* body = gridBodies[bit].get();
+        body->worldId = nextId++;
+        body->setStatic(true);
+        body->setTile(true);
+        body->setTrigger(false);
+        body->setMassless(true);
+        std::string name = CollisionLayers::getName(1u << bit);
+        if (!name.empty()) {
+            body->setTag(name);
+        }
+        body->setCollisionLayer(1u << bit);
+    }
+
+    // Kept covering the grid, for anything reading the other object's box in a contact event
+    if (collisionGrid) {
+        gridBodies[bit]->collisionBox = collisionGrid->getBounds();
+    }
+    return gridBodies[bit].get();
+}
+
+void World::collideGrid()
+{
+    if (!collisionGrid) return;
+
+    // Each dynamic object only looks at the cells under its box. Added after the object pairs, in body order
+    CollisionGrid::GridContact contacts[CollisionGrid::maxContacts];
+    for (auto& obj : dynamicBodies) {
+        int count = collisionGrid->collide(obj->collisionBox, obj->collisionLayer, obj->collisionMask, contacts);
+        size_t objectStart = manifolds.size();
+        for (int i = 0; i < count; ++i) {
+            // One pair per layer of cell touched, with a manifold for each face pushing on the object
+            GameObject* grid = getGridBody(contacts[i].layer);
+            int pairIndex = -1;
+            for (int j = (int)pairs.size() - 1; j >= 0 && pairs[j].first == obj; --j) {
+                if (pairs[j].second == grid) pairIndex = j;
+            }
+            if (pairIndex == -1) {
+                pairIndex = (int)pairs.size();
+                pairs.push_back({ obj->worldId, grid->worldId, obj, grid });
+            }
+
+            Manifold manifold;
+            manifold.pairIndex = pairIndex;
+            manifold.result = GameObject::CollisionResult::Resolve;
+            manifold.normal = contacts[i].normal;
+            manifold.depth = contacts[i].depth;
+            manifolds.push_back(manifold);
+        }
+
+        // Manifolds of the same pair next to each other, still deepest first, as the contact events expect
+        std::stable_sort(manifolds.begin() + objectStart, manifolds.end(), [](const Manifold& a, const Manifold& b) {
+            return a.pairIndex < b.pairIndex;
+        });
+    }
+}
+
+void World::detectCollisions()
+{
+    // Below this many pairs per thread, waking the workers costs more than it saves
+    const int minPairsPerThread = 128;
+
+    int threadCount = threadPool.getThreadCount();
+    if ((int)threadManifolds.size() < threadCount) {
+        threadManifolds.resize(threadCount);
+    }
+    for (auto& buffer : threadManifolds) {
+        buffer.clear();
+    }
+
+    // Only reads the objects, so any number of pairs can be tested at once
+    auto detect = [this](int begin, int end, int threadIndex) {
+        std::vector<Manifold>& buffer = threadManifolds[threadIndex];
+        for (int i = begin; i < end; ++i) {
+            const CollisionPair& pair = pairs[i];
+            GameObject::CollisionResult result = pair.first->testCollision(pair.second);
+            if (result == GameObject::CollisionResult::None) continue;
+
+            // Collision boxes are only updated by the integration, so they hold the overlap before it is resolved.
+            // The boxes overlapping is enough for two Box colliders, any other shapes are tested exactly here
+            Manifold manifold;
+            manifold.pairIndex = i;
+            manifold.result = result;
+            manifold.depth = 0.f;
+            if (!Narrowphase::collide(pair.first->getPlacedCollider(), pair.second->getPlacedCollider(), manifold.normal, manifold.depth)) continue;
+            buffer.push_back(manifold);
+        }
+    };
+
+    int pairCount = (int)pairs.size();
+    if (threadCount == 1 || pairCount < threadCount * minPairsPerThread) {
+        detect(0, pairCount, 0);
+    }
+    else {
+        threadPool.parallelFor(pairCount, detect);
+    }
+
+    // Each thread was given a contiguous range in order, so joining the buffers in thread order keeps the pair order
+    manifolds.clear();
+    for (auto& buffer : threadManifolds) {
+        manifolds.insert(manifolds.end(), buffer.begin(), buffer.end());
+    }
+}
+
+int World::UpdateFixed(float frameTime)
+{
+    accumulator += std::max(frameTime, 0.f);
+
+    int steps = 0;
+    while (accumulator >= fixedStep && steps < maxSubSteps) {
+        accumulator -= fixedStep;
+        ++steps;
+    }
+
+    // Hit the substep limit, drop the whole steps that are left and keep the fraction for interpolation
+    if (accumulator >= fixedStep) {
+        accumulator = std::fmod(accumulator, fixedStep);
+    }
+
+    runSteps(steps);
+    alpha = accumulator / fixedStep;
+    // Every rendered frame, including those too short for a step
+    updateObjects(std::max(frameTime, 0.f));
+    return steps;
+}
+
+int World::UpdateSteps(int steps)
+{
+    steps = std::max(steps, 0);
+    runSteps(steps);
+    alpha = 1.f;
+    updateObjects(fixedStep * steps);
+    return steps;
+}
+
+int World::runSteps(int steps)
+{
+    if (steps <= 0) return 0;
+
+    // Bodies are pulled from the objects once for all of the frame's steps
+    bodies.pull();
+    for (int i = 0; i < steps; ++i) {
+        step(fixedStep);
+    }
+    bodies.push();
+    return steps;
 }
 
 void World::UpdatePhysics(float deltaTime)
 {
+    // Stepped directly, nothing to blend
+    alpha = 1.f;
+
+    bodies.pull();
+    step(deltaTime);
+    bodies.push();
+    updateObjects(deltaTime);
+}
+
+void World::setDeterministic(bool d)
+{
+    deterministic = d;
+    // Sorted by the next step
+    bodyOrderDirty = d;
+    staticDirty = staticDirty || d;
+}
+
+void World::sortBodies(std::vector<GameObject*>& list)
+{
+    std::sort(list.begin(), list.end(), [](const GameObject* a, const GameObject* b) {
+        return a->worldId < b->worldId;
+    });
+    for (int i = 0; i < (int)list.size(); ++i) {
+        list[i]->bodyIndex = i;
+    }
+}
+
+std::uint64_t World::getStateHash() const
+{
+    std::vector<const GameObject*> ordered(objects.begin(), objects.end());
+    std::sort(ordered.begin(), ordered.end(), [](const GameObject* a, const GameObject* b) {
+        return a->worldId < b->worldId;
+    });
+
+    // FNV-1a over the bits of each value, so -0 and 0 or two NaNs are told apart
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (bits >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const GameObject* obj : ordered) {
+        // Read from the store while it is live, the objects are only written back at the end of the frame
+        int body = bodies.indexOf(obj);
+        sf::Vector2f position = body != -1 ? bodies.getPosition(body) : obj->getPosition();
+        sf::Vector2f velocity = body != -1 ? bodies.getVelocity(body) : obj->velocity;
+        add(position.x);
+        add(position.y);
+        add(velocity.x);
+        add(velocity.y);
+        add(obj->collisionBox.left);
+        add(obj->collisionBox.top);
+        add(obj->collisionBox.width);
+        add(obj->collisionBox.height);
+    }
+    return hash;
+}
+
+void World::updateObjects(float deltaTime)
+{
+    // Sleeping objects are updated too, they stay asleep unless update moves them. Objects added by an update wait for the next frame
+    updating.assign(dynamicBodies.begin(), dynamicBodies.end());
+    updating.insert(updating.end(), sleepingBodies.begin(), sleepingBodies.end());
+    for (GameObject* obj : updating) {
+        // Removed by an earlier update
+        if (obj->world != this) continue;
+        obj->update(deltaTime);
+    }
+}
+
+void World::step(float deltaTime)
+{
+    locked = true;
+    ++stepCount;
+
+    if (staticDirty) {
+        rebuildStaticIndex();
+    }
+    // Removals swap the last object into the gap, put them back in creation order
+    if (bodyOrderDirty) {
+        sortBodies(dynamicBodies);
+        bodyOrderDirty = false;
+    }
+    if (sleepingDirty) {
+        sleepingBoxes.clear();
+        for (auto& obj : sleepingBodies) {
+            sleepingBoxes.add(obj->collisionBox);
+        }
+        sleepingDirty = false;
+    }
 
     // Clear collision states after all updates and collisions have been handled
-    for (auto& obj : objects) {
+    // Static objects only need clearing if they were hit last step
+    for (auto& obj : touchedStatics) {
+        obj->clearCollision();
+    }
+    touchedStatics.clear();
+    for (auto& obj : dynamicBodies) {
         obj->clearCollision();
     }
 
-    // Apply gravity to all non-static objects and update their physics
-    for (auto& obj : objects) {
-        // Update object physics
-        obj->UpdatePhysics(&gravity, deltaTime);
-        obj->update(deltaTime);
+    // Gravity and movement for every dynamic object at once, then the new boxes for collision detection
+    bodies.integrate(deltaTime);
+    bodies.writeBoxes();
+
+    // The tree is brought up to date first, the bullet sweep queries it
+    updateTree(deltaTime);
+    sweepBullets();
+    findPairs();
+    detectCollisions();
+    collideGrid();
+
+    // Anything touching an awake object wakes up, along with its island, before the solver so it is moved this step
+    for (auto& manifold : manifolds) {
+        const CollisionPair& pair = pairs[manifold.pairIndex];
+        if (pair.first->sleeping) wakeObject(*pair.first);
+        if (pair.second->sleeping) wakeObject(*pair.second);
     }
-    // Handle collision checks
-    for (auto it1 = objects.begin(); it1 != objects.end(); ++it1) {
-        for (auto it2 = std::next(it1); it2 != objects.end(); ++it2) {
-            if ((*it1)->checkCollision(*it2)) {
-                // Call collision response here if needed
-                //std::cout << "Collision is happening\n";
-                (*it1)->collisionResponse(*it2);
-                (*it2)->collisionResponse(*it1);
-            }
+
+    // Solve every contact that needs resolving together, warm started with last step's impulse if the normal has not changed
+    solver.clear();
+    solverContacts.clear();
+    for (auto& manifold : manifolds) {
+        int index = -1;
+        if (manifold.result == GameObject::CollisionResult::Resolve) {
+            const CollisionPair& pair = pairs[manifold.pairIndex];
+            const Contact* previous = contactManager.findContact(pair.firstId, pair.secondId);
+            float warmImpulse = (previous && previous->normal == manifold.normal) ? previous->normalImpulse : 0.f;
+            index = solver.addContact(pair.first, pair.second, manifold.normal, manifold.depth, warmImpulse);
+        }
+        solverContacts.push_back(index);
+    }
+    solver.solve();
+
+    // Report the collisions in pair order
+    contactManager.beginStep();
+    for (size_t i = 0; i < manifolds.size(); ++i) {
+        const Manifold& manifold = manifolds[i];
+        CollisionPair& pair = pairs[manifold.pairIndex];
+
+        float impulse = 0.f;
+        if (solverContacts[i] != -1) {
+            pair.first->setContactNormal(pair.second, manifold.normal);
+            pair.second->setContactNormal(pair.first, -manifold.normal);
+            impulse = solver.getImpulse(solverContacts[i]);
+        }
+
+        // A grid pair can have a manifold per face, the deepest comes first and is the one reported
+        if (i > 0 && manifolds[i - 1].pairIndex == manifold.pairIndex) continue;
+
+        // Call collision response here if needed
+        //std::cout << "Collision is happening\n";
+        pair.first->collisionResponse(pair.second);
+        pair.second->collisionResponse(pair.first);
+
+        if (pair.first->getStatic()) touchedStatics.push_back(pair.first);
+        if (pair.second->getStatic()) touchedStatics.push_back(pair.second);
+
+        contactManager.addContact(pair.firstId, pair.secondId, pair.first, pair.second, manifold.normal, manifold.depth, impulse);
+    }
+    contactManager.endStep();
+
+    updateSleep(deltaTime);
+    applyRemovals();
+}
+
+void World::markStaticDirty()
+{
+    staticDirty = true;
+
+    // Static objects have moved, wake everything in case it was resting on them
+    while (!sleepingBodies.empty()) {
+        wakeObject(*sleepingBodies.back());
+    }
+}
+
+void World::setSleepEnabled(bool enabled)
+{
+    sleepEnabled = enabled;
+    if (!sleepEnabled) {
+        while (!sleepingBodies.empty()) {
+            wakeObject(*sleepingBodies.back());
+        }
+    }
+}
+
+int World::findIsland(int body)
+{
+    while (islandParent[body] != body) {
+        islandParent[body] = islandParent[islandParent[body]];
+        body = islandParent[body];
+    }
+    return body;
+}
+
+void World::updateSleep(float deltaTime)
+{
+    if (!sleepEnabled) return;
+
+    int count = bodies.size();
+    bodies.updateSleepTimes(deltaTime, sleepSpeed);
+
+    // Bodies pushing on each other are one island, static objects do not join islands together
+    islandParent.resize(count);
+    for (int i = 0; i < count; ++i) {
+        islandParent[i] = i;
+    }
+    for (size_t i = 0; i < manifolds.size(); ++i) {
+        if (solverContacts[i] == -1) continue;
+        const CollisionPair& pair = pairs[manifolds[i].pairIndex];
+        int a = bodies.indexOf(pair.first);
+        int b = bodies.indexOf(pair.second);
+        if (a != -1 && b != -1) {
+            islandParent[findIsland(a)] = findIsland(b);
+        }
+    }
+
+    // An island can sleep once its most recently moving body has been still long enough
+    islandSleepTime.assign(count, std::numeric_limits<float>::infinity());
+    for (int i = 0; i < count; ++i) {
+        int root = findIsland(i);
+        islandSleepTime[root] = std::min(islandSleepTime[root], bodies.getSleepTime(i));
+    }
+
+    // Link each sleeping island into a ring, then take its bodies out of the store. Collected first as removing reorders the store
+    islandHead.assign(count, nullptr);
+    islandTail.assign(count, nullptr);
+    fallingAsleep.clear();
+    for (int i = 0; i < count; ++i) {
+        int root = findIsland(i);
+        if (islandSleepTime[root] < timeToSleep) continue;
+
+        GameObject* obj = bodies.getObject(i);
+        if (islandHead[root] == nullptr) {
+            islandHead[root] = obj;
+        }
+        else {
+            islandTail[root]->nextInIsland = obj;
         }
+        islandTail[root] = obj;
+        fallingAsleep.push_back(obj);
     }
+    for (int i = 0; i < count; ++i) {
+        if (islandHead[i]) {
+            islandTail[i]->nextInIsland = islandHead[i];
+        }
+    }
+    for (auto& obj : fallingAsleep) {
+        sleepObject(obj);
+    }
+}
+
+void World::sleepObject(GameObject* obj)
+{
+    // The store writes its state back to the object as it leaves
+    bodies.remove(obj);
+    removeFromList(dynamicBodies, obj);
+    bodyOrderDirty = bodyOrderDirty || deterministic;
+
+    obj->sleeping = true;
+    obj->velocity = sf::Vector2f(0.f, 0.f);
+    obj->previousPosition = obj->getPosition();
+    obj->bodyIndex = (int)sleepingBodies.size();
+    sleepingBodies.push_back(obj);
+    sleepingDirty = true;
 }
 
+void World::wakeObject(GameObject& obj)
+{
+    if (!obj.sleeping || obj.world != this) return;
 
+    GameObject* member = &obj;
+    do {
+        GameObject* next = member->nextInIsland;
+        removeFromList(sleepingBodies, member);
+        member->sleeping = false;
+        member->nextInIsland = nullptr;
+        member->bodyIndex = (int)dynamicBodies.size();
+        dynamicBodies.push_back(member);
+        bodies.add(member);
+        member = next;
+    } while (member && member != &obj);
+
+    sleepingDirty = true;
+    bodyOrderDirty = bodyOrderDirty || deterministic;
+}
+
+void World::unlinkIsland(GameObject* obj)
+{
+    // Rings are only as long as an island, walk round to the object before this one
+    if (obj->nextInIsland && obj->nextInIsland != obj) {
+        GameObject* previous = obj->nextInIsland;
+        while (previous->nextInIsland != obj) {
+            previous = previous->nextInIsland;
+        }
+        previous->nextInIsland = obj->nextInIsland;
+    }
+    obj->nextInIsland = nullptr;
+}
+
+void World::applyRemovals()
+{
+    // Stays locked so objects removed by the exit events sent from here are queued and picked up by the same loop
+    locked = true;
+    for (size_t i = 0; i < pendingRemovals.size(); ++i) {
+        removeNow(pendingRemovals[i]);
+    }
+    pendingRemovals.clear();
+    locked = false;
+}
+
+bool World::passesFilter(const GameObject* obj, std::uint32_t mask, const GameObject* ignore) const
+{
+    return obj != ignore && !obj->isTrigger && (obj->collisionLayer & mask) != 0;
+}
+
+bool World::raycast(sf::Vector2f start, sf::Vector2f end, RaycastHit& hit, std::uint32_t mask, const GameObject* ignore) const
+{
+    hit = RaycastHit();
+    sf::Vector2f displacement = end - start;
+    sf::FloatRect point(start.x, start.y, 0.f, 0.f);
+
+    // The tree clips the ray to the closest hit so far, so boxes further away are never visited
+    tree.raycast(start, end, [&](int proxy, float maxFraction) {
+        GameObject* obj = static_cast<GameObject*>(tree.getUserData(proxy));
+        if (!passesFilter(obj, mask, ignore)) return -1.f;
+
+        float fraction;
+        sf::Vector2f normal;
+        if (!Collision::sweepBoundingBox(point, displacement, obj->collisionBox, fraction, normal)) return -1.f;
+        if (fraction > maxFraction) return -1.f;
+
+        hit.object = obj;
+        hit.fraction = fraction;
+        hit.normal = -normal;
+        // A hit at the very start would stop the walk, keep it just above 0 so the tree carries on clipping
+        return std::max(fraction, std::numeric_limits<float>::min());
+    });
+
+    if (!hit.object) return false;
+    hit.point = start + displacement * hit.fraction;
+    return true;
+}
+
+// Interleaves the bits of the cell coordinates so points close together get close keys
+static std::uint32_t mortonKey(sf::Vector2f point)
+{
+    const float cellSize = 64.f;
+    auto spread = [](std::uint32_t v) {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    std::uint32_t x = (std::uint32_t)((int)std::floor(point.x / cellSize) + 0x8000);
+    std::uint32_t y = (std::uint32_t)((int)std::floor(point.y / cellSize) + 0x8000);
+    return spread(x) | (spread(y) << 1);
+}
+
+void World::raycastBatch(const std::vector<Ray>& rays, std::vector<RaycastHit>& hits, std::uint32_t mask, const GameObject* ignore)
+{
+    // Below this many rays per thread, waking the workers costs more than it saves
+    const int minRaysPerThread = 64;
+
+    int rayCount = (int)rays.size();
+    hits.resize(rayCount);
+
+    rayOrder.resize(rayCount);
+    for (int i = 0; i < rayCount; ++i) {
+        rayOrder[i] = i;
+    }
+    std::sort(rayOrder.begin(), rayOrder.end(), [&rays](int a, int b) {
+        std::uint32_t keyA = mortonKey(rays[a].start);
+        std::uint32_t keyB = mortonKey(rays[b].start);
+        return keyA < keyB || (keyA == keyB && a < b);
+    });
+
+    // Each ray writes only its own hit, so the rays can be cast on any thread
+    auto cast = [&](int begin, int end, int /*threadIndex*/) {
+        for (int i = begin; i < end; ++i) {
+            int index = rayOrder[i];
+            raycast(rays[index].start, rays[index].end, hits[index], mask, ignore);
+        }
+    };
+    if (threadPool.getThreadCount() == 1 || rayCount < threadPool.getThreadCount() * minRaysPerThread) {
+        cast(0, rayCount, 0);
+    }
+    else {
+        threadPool.parallelFor(rayCount, cast);
+    }
+}
+
+bool World::boxCast(const sf::FloatRect& box, sf::Vector2f displacement, RaycastHit& hit, std::uint32_t mask, const GameObject* ignore) const
+{
+    hit = RaycastHit();
+
+    float left = std::min(box.left, box.left + displacement.x);
+    float top = std::min(box.top, box.top + displacement.y);
+    sf::FloatRect swept(left, top,
+        std::max(box.left, box.left + displacement.x) + box.width - left,
+        std::max(box.top, box.top + displacement.y) + box.height - top);
+
+    // Earliest hit wins, ties go to the earlier created object so the result does not depend on the tree's shape
+    tree.query(swept, [&](int proxy) {
+        GameObject* obj = static_cast<GameObject*>(tree.getUserData(proxy));
+        if (!passesFilter(obj, mask, ignore)) return true;
+
+        float fraction;
+        sf::Vector2f normal;
+        if (Collision::sweepBoundingBox(box, displacement, obj->collisionBox, fraction, normal)) {
+            if (!hit.object || fraction < hit.fraction || (fraction == hit.fraction && obj->worldId < hit.object->worldId)) {
+                hit.object = obj;
+                hit.fraction = fraction;
+                hit.normal = -normal;
+            }
+        }
+        return true;
+    });
+
+    if (!hit.object) return false;
+    hit.point = sf::Vector2f(box.left, box.top) + displacement * hit.fraction;
+    return true;
+}
@@ -1,19 +1,329 @@
 #pragma once
 #include <iostream>
 #include <SFML/Graphics.hpp>
-#include <list>
+#include <vector>
+#include <algorithm>
 #include "GameObject.h"
+#include "SpatialHash.h"
+#include "SweepAndPrune.h"
+#include "AABBTree.h"
+#include "BoxBatch.h"
+#include "ContactManager.h"
+#include "ContactSolver.h"
+#include "ThreadPool.h"
+#include "SlotMap.h"
+#include "BodyStore.h"
+#include "CollisionGrid.h"
+#include <memory>
+
+// Broadphase strategies the world can use to find potentially colliding pairs
+enum class Broadphase { BruteForce, SpatialHash, SweepAndPrune, AABBTree };
+
+// Result of a ray or box cast
+struct RaycastHit
+{
+	GameObject* object = nullptr;	// null if nothing was hit
+	sf::Vector2f point;				// where the ray hit, for a box cast the box's position at the hit
+	sf::Vector2f normal;			// surface normal of the object hit, facing back along the cast
+	float fraction = 1.f;			// how far along the cast, 0 to 1
+};
+
+struct Ray
+{
+	sf::Vector2f start;
+	sf::Vector2f end;
+};
 
 class World
 {
-	std::list<GameObject*> objects; // becomes ptrs internally but never exposed
+	// A pair of objects that may be colliding, ids are the creation order used to keep resolution order stable
+	struct CollisionPair
+	{
+		int firstId;
+		int secondId;
+		GameObject* first;
+		GameObject* second;
+	};
+
+	// Every object in the world, packed together and looked up by handle
+	SlotMap<GameObject*> objects;
 	sf::Vector2f gravity;
+	int nextId;
+
+	// Fixed step accumulator, frame time is banked and spent in whole steps of 1 / stepRate
+	float fixedStep;
+	int maxSubSteps;
+	float accumulator;
+	float alpha;
+	int stepCount;
+
+	// Deterministic mode keeps the dynamic objects in creation order, sorting them again after removals
+	bool deterministic;
+	bool bodyOrderDirty;
+
+	// Objects split by their static flag. Static objects are only indexed when they change, never stepped
+	std::vector<GameObject*> dynamicBodies;
+	std::vector<GameObject*> staticBodies;
+	bool staticDirty;
+	std::vector<GameObject*> touchedStatics;		// static objects given a colliding tag last step, cleared next step
+
+	// Physics state of the awake dynamic objects, stepped in place and written back to the objects once per frame
+	BodyStore bodies;
+
+	// Sleeping objects are out of the dynamic list and the body store, so they cost nothing until woken.
+	// Awake objects still find them, through the tree or through their boxes for the brute force and spatial hash broadphases
+	std::vector<GameObject*> sleepingBodies;
+	BoxBatch sleepingBoxes;
+	bool sleepingDirty;
+	bool sleepEnabled;
+	float sleepSpeed;
+	float timeToSleep;
+	std::vector<int> islandParent;	// union find over the body store, bodies touching each other form an island
+	std::vector<float> islandSleepTime;
+	std::vector<GameObject*> islandHead;
+	std::vector<GameObject*> islandTail;
+	std::vector<GameObject*> fallingAsleep;
+
+	// Objects removed while a step is running are taken out at the end of it, once nothing is iterating over them
+	bool locked;
+	std::vector<GameObject*> pendingRemovals;
+	std::vector<GameObject*> updating;	// objects updated this frame, update can wake, add and remove objects so the lists are copied
+
+	Broadphase broadphase;
+	std::vector<CollisionPair> pairs;
+
+	// Brute force broadphase, every box in structure of arrays form so one box is tested against 4 or 8 at once.
+	// Static boxes are kept in staticBodies order, dynamic boxes are refilled every step
+	BoxBatch staticBoxes;
+	BoxBatch dynamicBoxes;
+	std::vector<int> batchHits;
+
+	// Continuous collision for bullets, swept when they move further than this fraction of their size in a step
+	float bulletThreshold;
+
+	// Spatial hash broadphase, the static hash is prebuilt, the dynamic hash is rebuilt every step
+	SpatialHash staticHash;
+	SpatialHash dynamicHash;
+	std::vector<std::pair<int, int>> dynamicPairs;
+	std::vector<int> staticCandidates;
+
+	// Sweep and prune broadphase over the dynamic objects, proxies persist between steps. Static objects are left out and found
+	// through the static hash, so the level's size does not add to the cost of a step
+	SweepAndPrune sweepAndPrune;
+	std::vector<GameObject*> proxyBodies;	// object owning each proxy
+	std::vector<std::pair<GameObject*, GameObject*>> addedPairs;
+	std::vector<std::pair<GameObject*, GameObject*>> removedPairs;
+	// Overlaps between dynamic and static objects, kept from the last step to report which began and ended. Held by handle,
+	// as either object may have been removed since
+	struct StaticPair
+	{
+		int firstId;
+		int secondId;
+		BodyHandle first;
+		BodyHandle second;
+	};
+	std::vector<StaticPair> staticPairs;
+	std::vector<StaticPair> previousStaticPairs;
+
+	// Dynamic AABB tree, every object has a proxy holding its fattened box. Used by the AABB tree broadphase and by the queries
+	AABBTree tree;
+
+	// Contacts kept between steps for the enter/stay/exit events
+	ContactManager contactManager;
+	// Solves every contact of a step together with impulses, warm started from the contact manager
+	ContactSolver solver;
+	std::vector<int> solverContacts;	// solver contact of each manifold, -1 if it is not resolved
+
+	std::vector<int> rayOrder;	// batched rays sorted by where they start
+
+	// Grid terrain, dynamic objects are tested against the cells they overlap after the pairs.
+	// Contacts with it are reported against a static stand in object for each layer of cell
+	CollisionGrid* collisionGrid;
+	std::unique_ptr<GameObject> gridBodies[32];
+
+	// Result of the narrowphase for one colliding pair, filled in by the detection threads
+	struct Manifold
+	{
+		int pairIndex;
+		GameObject::CollisionResult result;
+		sf::Vector2f normal;	// points from first towards second
+		float depth;
+	};
+
+	// Detection runs over the pairs on the thread pool, each thread writes into its own buffer.
+	// The buffers are joined in thread order, which is pair order, then resolved on the calling thread
+	ThreadPool threadPool;
+	std::vector<std::vector<Manifold>> threadManifolds;
+	std::vector<Manifold> manifolds;
+
+	void rebuildStaticIndex();
+	void step(float deltaTime);
+	int runSteps(int steps);
+	void sortBodies(std::vector<GameObject*>& list);
+	void updateSleep(float deltaTime);
+	int findIsland(int body);
+	void sleepObject(GameObject* obj);
+	void unlinkIsland(GameObject* obj);
+	bool isAwakeBody(GameObject* obj) const { return !obj->getStatic() && !obj->sleeping; }
+	void updateObjects(float deltaTime);
+	void applyRemovals();
+	void removeNow(GameObject* obj);
+	void removeStatic(GameObject* obj);
+	void removeFromList(std::vector<GameObject*>& list, GameObject* obj);
+	void createProxy(GameObject* obj);
+	void destroyProxy(GameObject* obj);
+	void updateTree(float deltaTime);
+	void findPairs();
+	void findPairsBruteForce();
+	void findPairsSpatialHash();
+	void findPairsSweepAndPrune();
+	void findPairsAABBTree();
+	void detectCollisions();
+	void sweepBullets();
+	void collideGrid();
+	bool passesFilter(const GameObject* obj, std::uint32_t mask, const GameObject* ignore) const;
 
 public:
 	World();
-	void setGravity(sf::Vector2f g) { gravity = g; }
-	void AddGameObject(GameObject& obj);
+	void setGravity(sf::Vector2f g) { gravity = g; bodies.setGravity(g); }
+	void setCellSize(float size);
+	void setBroadphase(Broadphase b);
+	Broadphase getBroadphase() const { return broadphase; }
+	// Bullets moving more than this fraction of their width or height in a step are swept to their first contact
+	void setBulletThreshold(float fraction) { bulletThreshold = fraction; }
+	float getBulletThreshold() const { return bulletThreshold; }
+	// Contact solver iterations, more velocity iterations make stacks stiffer, position iterations remove more overlap per step
+	void setSolverIterations(int velocity, int position) { solver.setIterations(velocity, position); }
+	int getVelocityIterations() const { return solver.getVelocityIterations(); }
+	int getPositionIterations() const { return solver.getPositionIterations(); }
+	// Threads used to test the pairs, 0 uses one per core. Results are the same for any thread count
+	void setThreadCount(int count) { threadPool.setThreadCount(count); }
+	int getThreadCount() const { return threadPool.getThreadCount(); }
+	// Adding and removing take constant time. Objects removed during a step (e.g. from a contact event) stay in the world until
+	// the step ends. Adding an object already in the world returns its existing handle
+	BodyHandle AddGameObject(GameObject& obj);
 	void RemoveGameObject(GameObject& obj);
+	void RemoveGameObject(BodyHandle handle);
+	// A handle is valid until its object is removed, getObject returns nullptr for a stale handle
+	bool isValid(BodyHandle handle) const { return objects.contains(handle); }
+	GameObject* getObject(BodyHandle handle) const;
+	int getObjectCount() const { return objects.size(); }
+	// Runs a single physics step of deltaTime seconds
 	void UpdatePhysics(float deltaTime);
+	// Banks the frame time and runs as many fixed steps as it covers, up to the max substeps. Returns the number of steps run.
+	// Time beyond the max is dropped, so a slow frame slows the game down rather than making the next frame slower still.
+	// Dynamic objects are written back to once, after the last step. Their update is then called with the frame time, on every frame
+	// even when it was too short for a step.
+	// During the steps their positions (getPosition) are those from the start of the frame, use the collision box for the current one
+	int UpdateFixed(float frameTime);
+
+	// Runs exactly this many fixed steps, ignoring the frame time. Use to replay a recording made with getStepCount
+	int UpdateSteps(int steps);
+	// Steps run since the world was created, tag recorded input with this so a replay can apply it at the same step
+	int getStepCount() const { return stepCount; }
+
+	// Deterministic mode, for replays and regression runs. Dynamic objects are stepped, swept and updated in creation order even after
+	// removals (which otherwise reorder them), so the same level and input give bit identical results on every run and any thread count.
+	// The world never reads the clock, drive it with UpdateSteps or with recorded frame times so the same steps are run
+	void setDeterministic(bool d);
+	bool isDeterministic() const { return deterministic; }
+	// Hash of every object's position, velocity and collision box in creation order. Equal hashes mean bit identical states
+	std::uint64_t getStateHash() const;
+
+	// Physics steps per second used by UpdateFixed
+	void setStepRate(float hz);
+	float getStepRate() const { return 1.f / fixedStep; }
+	float getFixedStep() const { return fixedStep; }
+	void setMaxSubSteps(int steps) { maxSubSteps = std::max(1, steps); }
+	int getMaxSubSteps() const { return maxSubSteps; }
+	// How far the leftover frame time is into the next step, 0 to 1. Pass to GameObject::getInterpolationTransform when drawing
+	float getAlpha() const { return alpha; }
+
+	// Call when static objects have been moved, resized or had their static flag changed (e.g. by the tile editor)
+	// The static index is rebuilt once at the start of the next step, and sleeping objects are woken in case they rested on them
+	void markStaticDirty();
+
+	// Objects that stop moving for a while are put to sleep, together with everything they are touching.
+	// Objects slower than speed (pixels per second) for time seconds can sleep, an island sleeps once all of it can
+	void setSleepEnabled(bool enabled);
+	bool getSleepEnabled() const { return sleepEnabled; }
+	void setSleepThresholds(float speed, float time) { sleepSpeed = speed; timeToSleep = time; }
+	float getSleepSpeed() const { return sleepSpeed; }
+	float getTimeToSleep() const { return timeToSleep; }
+	// Wakes a sleeping object and the rest of its island. Also called by GameObject::wake
+	void wakeObject(GameObject& obj);
+	int getAwakeCount() const { return (int)dynamicBodies.size(); }
+	int getSleepingCount() const { return (int)sleepingBodies.size(); }
+
+	// Every non static object, awake or sleeping
+	int getDynamicCount() const { return (int)(dynamicBodies.size() + sleepingBodies.size()); }
+	int getStaticCount() const { return (int)staticBodies.size(); }
+	// Number of candidate pairs passed to the narrowphase last step
+	int getPairCount() const { return (int)pairs.size(); }
+
+	// Pairs of objects whose boxes started/stopped overlapping last step, static objects included. Only filled by the sweep and
+	// prune broadphase
+	const std::vector<std::pair<GameObject*, GameObject*>>& getAddedPairs() const { return addedPairs; }
+	const std::vector<std::pair<GameObject*, GameObject*>>& getRemovedPairs() const { return removedPairs; }
+
+	// Contacts touching at the end of the last step, keyed by the pair of objects
+	int getContactCount() const { return contactManager.getContactCount(); }
+	const std::unordered_map<std::uint64_t, Contact>& getContacts() const { return contactManager.getContacts(); }
+
+	// Terrain for dynamic objects to collide with, nullptr for none. The grid is not owned and must outlive its use by the world.
+	// Contacts with it have a static stand in object as the other object, on the cell's layer and tagged with the layer's name
+	void setCollisionGrid(CollisionGrid* grid) { collisionGrid = grid; }
+	CollisionGrid* getCollisionGrid() const { return collisionGrid; }
+	// Stand in for the grid's cells on a layer, e.g. to recognise it in contact events
+	GameObject* getGridBody(std::uint32_t layer);
+
+	// The tree holding every object, for custom spatial queries (fat boxes, user data is the GameObject)
+	const AABBTree& getTree() const { return tree; }
+
+	// Calls callback(GameObject*) for every object whose collision box overlaps the rect. Return false from the callback to stop.
+	// Static objects changed since the last step are re-indexed first, so the results are always current
+	template <typename T>
+	void queryAABB(const sf::FloatRect& rect, T&& callback);
+	// Calls callback(GameObject*) for every object whose collision box contains the point, edges included
+	template <typename T>
+	void queryPoint(sf::Vector2f point, T&& callback);
+
+	// Casts a ray from start to end and finds the closest object it hits. Only objects on a layer in the mask are hit,
+	// triggers and the ignored object are skipped, and objects the ray starts inside are not counted. Returns false on a miss
+	bool raycast(sf::Vector2f start, sf::Vector2f end, RaycastHit& hit, std::uint32_t mask = CollisionLayers::All, const GameObject* ignore = nullptr) const;
+	// Casts many rays at once, hits[i] is the result of rays[i] with a null object on a miss.
+	// Rays are cast in order of where they start so nearby rays walk the same parts of the tree, big batches are split over the threads
+	void raycastBatch(const std::vector<Ray>& rays, std::vector<RaycastHit>& hits, std::uint32_t mask = CollisionLayers::All, const GameObject* ignore = nullptr);
+	// Sweeps a box by the displacement and finds the first object it touches. The hit point is where the box's top left corner
+	// is when they touch, the normal is the surface normal of the object hit
+	bool boxCast(const sf::FloatRect& box, sf::Vector2f displacement, RaycastHit& hit, std::uint32_t mask = CollisionLayers::All, const GameObject* ignore = nullptr) const;
 };
 
+template <typename T>
+void World::queryAABB(const sf::FloatRect& rect, T&& callback)
+{
+	if (staticDirty) rebuildStaticIndex();
+
+	// The tree holds fat boxes, so check the real collision box before reporting
+	tree.query(rect, [&](int proxy) {
+		GameObject* obj = static_cast<GameObject*>(tree.getUserData(proxy));
+		if (!obj->collisionBox.intersects(rect)) return true;
+		return (bool)callback(obj);
+	});
+}
+
+template <typename T>
+void World::queryPoint(sf::Vector2f point, T&& callback)
+{
+	if (staticDirty) rebuildStaticIndex();
+
+	tree.queryPoint(point, [&](int proxy) {
+		GameObject* obj = static_cast<GameObject*>(tree.getUserData(proxy));
+		const sf::FloatRect& box = obj->collisionBox;
+		if (point.x < std::min(box.left, box.left + box.width) || point.x > std::max(box.left, box.left + box.width) ||
+			point.y < std::min(box.top, box.top + box.height) || point.y > std::max(box.top, box.top + box.height)) {
+			return true;
+		}
+		return (bool)callback(obj);
+	});
+}
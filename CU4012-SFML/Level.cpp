@@ -24,6 +24,7 @@ Level::Level(sf::RenderWindow* hwnd, Input* in, GameState* gs,sf::View* v, World
 
 	//world->AddGameObject(zomb);
 	world->AddGameObject(mario);
+	collectablesShown = 0;
 
 	CollectableCollected.setFont(font);
 	CollectableCollected.setCharacterSize(24);
@@ -63,6 +64,11 @@ void Level::handleInput(float dt)
 		input->setKeyUp(sf::Keyboard::Tab);
 		gameState->setCurrentState(State::TILEEDITOR);
 	}
+	if (input->isKeyDown(sf::Keyboard::F3))
+	{
+		input->setKeyUp(sf::Keyboard::F3);
+		showRenderStats = !showRenderStats;
+	}
 	mario.handleInput(dt);
 }
 
@@ -72,20 +78,19 @@ void Level::update(float dt)
 	sf::Vector2f viewSize = sf::Vector2f(window->getSize().x, window->getSize().y);
 	CollectableCollected.setPosition(view->getCenter().x - viewSize.x / 2.1 , view->getCenter().y - viewSize.y / 2.04);
 	CollectablesUI.setPosition(view->getCenter().x - viewSize.x / 2, view->getCenter().y - viewSize.y / 2);
-	if (mario.CollisionWithTag("Collectable"))
+	// Mario counts collectables as he touches them (Mario::OnCollisionEnter), once per contact
+	if (mario.getCollectableCount() != collectablesShown)
 	{
-		// Player is Colliding with Ring
-		mario.addCollected(1); // Increment ring count
-		tileManager->RemoveCollectable(); // Remove the collectable tile
+		tileManager->RemoveCollectable(); // Remove the collected tiles
 
 		// Update the RingsCollectedText to display the new number of rings collected
-		int ringCount = mario.getCollectableCount(); // Assume p1 is the player object and has the getRingCount method
-		CollectableCollected.setString("X" + std::to_string(ringCount));
+		collectablesShown = mario.getCollectableCount();
+		CollectableCollected.setString("X" + std::to_string(collectablesShown));
 	}
 
 	//Move the view to follow the player
 	view->setCenter(view->getCenter().x, 500);
-	sf::Vector2f playerPosition = mario.getPosition();
+	sf::Vector2f playerPosition = mario.getInterpolatedPosition(world->getAlpha());
 	float newX = std::max(playerPosition.x, view->getSize().x / 2.0f);
 	view->setCenter(newX, view->getCenter().y);
 	window->setView(*view);
@@ -97,9 +102,13 @@ void Level::render()
 	if (gameState->getCurrentState() == State::LEVEL)
 	{
 		tileManager->render(false);
+		if (showRenderStats)
+		{
+			tileManager->DrawRenderStats();
+		}
 	}
 	// Render level
-	window->draw(mario);
+	window->draw(mario, mario.getInterpolationTransform(world->getAlpha()));
 	window->draw(CollectablesUI);
 	window->draw(CollectableCollected);
 }
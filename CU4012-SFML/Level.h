@@ -28,4 +28,7 @@ private:
 	sf::Sprite CollectablesUI;
 	sf::Font font;
 	sf::Texture CollectablesUITex;
+
+	int collectablesShown;
+	bool showRenderStats = false;	// F3 toggles the tile render stats overlay
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 Mario::Mario()
 {
 	speed = 200;
+	noOfCoinsCollected = 0;
 
 	marioSpriteSheet.loadFromFile("gfx/MarioSheetT.png");
 	setSize(sf::Vector2f(15*4, 21*4));
@@ -36,13 +37,13 @@ void Mario::handleInput(float dt)
 
 	if (input->isKeyDown(sf::Keyboard::A))
 	{
-		velocity.x = -speed;
+		setVelocity(-speed, getVelocity().y);
 		currentAnimation = &walk;
 		currentAnimation->setFlipped(true);
 	}
 	else if (input->isKeyDown(sf::Keyboard::D))
 	{
-		velocity.x = speed;
+		setVelocity(speed, getVelocity().y);
 		currentAnimation = &walk;
 		currentAnimation->setFlipped(false);
 	}
@@ -64,3 +65,13 @@ void Mario::handleInput(float dt)
 
 	currentAnimation->animate(dt);
 }
+
+// Collect each collectable once, when the contact begins. The level removes the collected tiles.
+void Mario::OnCollisionEnter(GameObject* other, const Contact& /*contact*/)
+{
+	if ((other->getCollisionLayer() & CollisionLayers::Collectable) && other->isAlive())
+	{
+		addCollected(1);
+		other->setAlive(false);
+	}
+}
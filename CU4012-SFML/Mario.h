@@ -16,6 +16,7 @@ class Mario : public GameObject
 public:
 	Mario();
 	void handleInput(float dt) override;
+	void OnCollisionEnter(GameObject* other, const Contact& contact) override;
 	void addCollected(int count) { noOfCoinsCollected += count; }
 	int getCollectableCount() { return noOfCoinsCollected; }
 };